@@ -0,0 +1,100 @@
+/**
+ * @file backend.c
+ *
+ * Selection of the backend used to drive the GPIO expanders.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "backend.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * All the available backends.  The first one is the default.
+ */
+//--------------------------------------------------------------------------------------------------
+static const backend_Ops_t* const Backends[] =
+{
+    &backend_Gpio,
+    &backend_Stub,
+#ifndef MUXCTRL_NO_CDEV_BACKEND
+    &backend_Cdev,
+#endif
+    &backend_I2c,
+    &backend_Mock,
+};
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Convert a group of pins on one expander (bit masks of pinState_Pin_t values) to the matching
+ * bits of the expander's registers.
+ */
+//--------------------------------------------------------------------------------------------------
+void backend_ToRegister
+(
+    uint8_t expander,       ///< Expander that all the pins are on
+    uint32_t pinMask,       ///< Pins
+    uint32_t pinValues,     ///< Values of the pins
+    uint16_t* regMaskPtr,   ///< [OUT] Register bits of the pins
+    uint16_t* regValuesPtr  ///< [OUT] Register bits of the pins that are set
+)
+{
+    uint16_t regMask = 0;
+    uint16_t regValues = 0;
+
+    for (int pin = 0; pin < PIN_COUNT; pin++)
+    {
+        if (pinMask & (1 << pin))
+        {
+            LE_ASSERT(pinState_GetExpander(pin) == expander);
+
+            uint16_t bit = 1 << pinState_GetExpanderPin(pin);
+            regMask |= bit;
+            if (pinValues & (1 << pin))
+            {
+                regValues |= bit;
+            }
+        }
+    }
+
+    *regMaskPtr = regMask;
+    *regValuesPtr = regValues;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Select the backend to use.  The MUXCTRL_BACKEND environment variable names the backend; the
+ * le_gpio backend is used if it is not set.  An unknown name is fatal, rather than quietly driving
+ * the real expanders when a stand-in backend was asked for.
+ */
+//--------------------------------------------------------------------------------------------------
+const backend_Ops_t* backend_Select
+(
+    void
+)
+{
+    const char* namePtr = getenv("MUXCTRL_BACKEND");
+
+    if (namePtr == NULL)
+    {
+        return Backends[0];
+    }
+
+    for (int i = 0; i < NUM_ARRAY_MEMBERS(Backends); i++)
+    {
+        if (strcmp(namePtr, Backends[i]->name) == 0)
+        {
+            return Backends[i];
+        }
+    }
+
+    LE_FATAL("Unknown backend '%s' in MUXCTRL_BACKEND", namePtr);
+}
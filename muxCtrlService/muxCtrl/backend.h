@@ -0,0 +1,116 @@
+/**
+ * @file backend.h
+ *
+ * Interface between the pin state cache and the code that actually drives the GPIO expanders.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#ifndef MUXCTRL_BACKEND_H_INCLUDE_GUARD
+#define MUXCTRL_BACKEND_H_INCLUDE_GUARD
+
+#include "pinState.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Operations provided by a backend.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    const char* name;   ///< Name used to select the backend
+
+    /// Prepare the backend for use (optional).  Called on the thread that will use the backend.
+    le_result_t (*init)(void);
+
+    /// Configure a pin as a push-pull output with the given initial value.
+    le_result_t (*configure)(pinState_Pin_t pin, bool value);
+
+    /// Read back the state of a pin that is already configured as an output (optional).  Returns
+    /// LE_UNAVAILABLE if the pin is not configured as an output.
+    le_result_t (*read)(pinState_Pin_t pin, bool* activePtr);
+
+    /// Set the pins in pinMask (a bit mask of pinState_Pin_t values, all on the given expander)
+    /// to the matching bits of pinValues.  A backend that can do so should make this a single
+    /// register write.  pinOrderPtr lists the same pins in the order they were added to the
+    /// transition; a backend that sets the pins one at a time must set them in that order, so
+    /// that a mux's select changes before its enable.
+    le_result_t (*write)(uint8_t expander, uint32_t pinMask, uint32_t pinValues,
+                         const pinState_Pin_t* pinOrderPtr);
+
+    /// Get the number of bus transactions made to the expanders so far (optional).  May be called
+    /// from any thread.
+    uint32_t (*getTransactionCount)(void);
+}
+backend_Ops_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Backend that drives each pin through its own le_gpio interface on gpioExpanderServiceGreen.
+ */
+//--------------------------------------------------------------------------------------------------
+extern const backend_Ops_t backend_Gpio;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Backend that drives a local stand-in for the expanders instead of real hardware.  It keeps an
+ * output register per expander.
+ */
+//--------------------------------------------------------------------------------------------------
+extern const backend_Ops_t backend_Stub;
+
+#ifndef MUXCTRL_NO_CDEV_BACKEND
+//--------------------------------------------------------------------------------------------------
+/**
+ * Backend that drives the expander lines directly through the Linux GPIO character device.  Left
+ * out of builds against kernel headers without the v2 uAPI (see Component.cdef).
+ */
+//--------------------------------------------------------------------------------------------------
+extern const backend_Ops_t backend_Cdev;
+#endif
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Backend that drives the SX1509 expander registers directly over I2C.  The kernel's sx150x
+ * driver must not be bound to the expanders.
+ */
+//--------------------------------------------------------------------------------------------------
+extern const backend_Ops_t backend_I2c;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Backend for tests and benchmarks on a plain Linux host.  It models the expanders like the stub
+ * backend, and records calls and simulates latency and failures.
+ */
+//--------------------------------------------------------------------------------------------------
+extern const backend_Ops_t backend_Mock;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Convert a group of pins on one expander (bit masks of pinState_Pin_t values) to the matching
+ * bits of the expander's registers.
+ */
+//--------------------------------------------------------------------------------------------------
+void backend_ToRegister
+(
+    uint8_t expander,       ///< Expander that all the pins are on
+    uint32_t pinMask,       ///< Pins
+    uint32_t pinValues,     ///< Values of the pins
+    uint16_t* regMaskPtr,   ///< [OUT] Register bits of the pins
+    uint16_t* regValuesPtr  ///< [OUT] Register bits of the pins that are set
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Select the backend to use.  The MUXCTRL_BACKEND environment variable names the backend; the
+ * le_gpio backend is used if it is not set.  The service exits if it names an unknown backend.
+ */
+//--------------------------------------------------------------------------------------------------
+const backend_Ops_t* backend_Select
+(
+    void
+);
+
+#endif // MUXCTRL_BACKEND_H_INCLUDE_GUARD
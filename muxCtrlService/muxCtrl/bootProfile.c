@@ -0,0 +1,243 @@
+/**
+ * @file bootProfile.c
+ *
+ * Routing and reset states to start with, read from the config tree.  The profile lives in the
+ * service's own config tree, for example:
+ *
+ * @verbatim
+    config set muxCtrlService:/bootProfile/uart1 iot0
+    config set muxCtrlService:/bootProfile/spi off
+    config set muxCtrlService:/bootProfile/uart2 debug
+    config set muxCtrlService:/bootProfile/sdio microsd
+    config set muxCtrlService:/bootProfile/audio onboard
+    config set muxCtrlService:/bootProfile/reset/iot0 false bool
+   @endverbatim
+ *
+ * Each reset entry is true to hold the target in reset and false to let it run.  Anything that is
+ * not in the profile starts in its default state.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "routing.h"
+#include "bootProfile.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Config tree path of the boot profile.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PROFILE_PATH "/bootProfile"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Longest route name accepted in the profile, including the terminator.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_ROUTE_NAME_BYTES 16
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Route names accepted in the profile, and the route enum value each one stands for.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    const char* name;
+    int route;
+}
+RouteName_t;
+
+static const RouteName_t Uart1Routes[] =
+{
+    { "off",  MANGOH_MUXCTRL_UART1_OFF  },
+    { "iot0", MANGOH_MUXCTRL_UART1_IOT0 },
+    { "iot1", MANGOH_MUXCTRL_UART1_IOT1 },
+    { NULL },
+};
+
+static const RouteName_t SpiRoutes[] =
+{
+    { "off",  MANGOH_MUXCTRL_SPI_OFF  },
+    { "iot0", MANGOH_MUXCTRL_SPI_IOT0 },
+    { "iot1", MANGOH_MUXCTRL_SPI_IOT1 },
+    { NULL },
+};
+
+static const RouteName_t Uart2Routes[] =
+{
+    { "off",   MANGOH_MUXCTRL_UART2_OFF   },
+    { "iot2",  MANGOH_MUXCTRL_UART2_IOT2  },
+    { "debug", MANGOH_MUXCTRL_UART2_DEBUG },
+    { NULL },
+};
+
+static const RouteName_t SdioRoutes[] =
+{
+    { "microsd", MANGOH_MUXCTRL_SDIO_MICROSD },
+    { "iot0",    MANGOH_MUXCTRL_SDIO_IOT0    },
+    { NULL },
+};
+
+static const RouteName_t AudioRoutes[] =
+{
+    { "disabled", MANGOH_MUXCTRL_AUDIO_DISABLED       },
+    { "iot0",     MANGOH_MUXCTRL_AUDIO_IOT0_CODEC     },
+    { "onboard",  MANGOH_MUXCTRL_AUDIO_ONBOARD_CODEC  },
+    { "internal", MANGOH_MUXCTRL_AUDIO_INTERNAL_CODEC },
+    { NULL },
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reset entries of the profile.
+ */
+//--------------------------------------------------------------------------------------------------
+static const struct
+{
+    const char* node;
+    mangoh_muxCtrl_ResetTarget_t target;
+}
+ResetEntries[] =
+{
+    { "reset/iot0",    MANGOH_MUXCTRL_RESET_IOT0    },
+    { "reset/iot1",    MANGOH_MUXCTRL_RESET_IOT1    },
+    { "reset/iot2",    MANGOH_MUXCTRL_RESET_IOT2    },
+    { "reset/arduino", MANGOH_MUXCTRL_RESET_ARDUINO },
+};
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read a route entry of the profile.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_NOT_FOUND if the entry is not in the profile
+ *      - LE_BAD_PARAMETER if the entry does not name a route
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ReadRoute
+(
+    le_cfg_IteratorRef_t iteratorRef,
+    const char* node,               ///< Entry to read
+    const RouteName_t* routesPtr,   ///< Route names accepted for the entry
+    int* routePtr                   ///< [OUT] Route
+)
+{
+    char name[MAX_ROUTE_NAME_BYTES];
+
+    if (!le_cfg_NodeExists(iteratorRef, node))
+    {
+        return LE_NOT_FOUND;
+    }
+
+    if (le_cfg_GetString(iteratorRef, node, name, sizeof(name), "") == LE_OK)
+    {
+        for (; routesPtr->name != NULL; routesPtr++)
+        {
+            if (strcmp(name, routesPtr->name) == 0)
+            {
+                *routePtr = routesPtr->route;
+                return LE_OK;
+            }
+        }
+    }
+
+    LE_WARN("Ignoring invalid boot profile entry '%s' (%s)", node, name);
+    return LE_BAD_PARAMETER;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the pin changes of a profile to a transition, but only for the pins that are not already in
+ * the transition.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Merge
+(
+    pinState_Transition_t* transitionPtr,
+    const pinState_Transition_t* profilePtr
+)
+{
+    for (int pin = 0; pin < PIN_COUNT; pin++)
+    {
+        if ((profilePtr->mask & (1 << pin)) && !(transitionPtr->mask & (1 << pin)))
+        {
+            pinState_AddPin(transitionPtr, pin, (profilePtr->values & (1 << pin)) != 0);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the pin states selected by the boot profile in the config tree to a transition.  Pins that
+ * are already in the transition are left as they are.  Entries that are missing from the profile
+ * are skipped, as are entries with invalid values (which are also logged).
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_NOT_FOUND if there is no boot profile
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t bootProfile_Load
+(
+    pinState_Transition_t* transitionPtr  ///< Transition to add to
+)
+{
+    le_cfg_IteratorRef_t iteratorRef = le_cfg_CreateReadTxn(PROFILE_PATH);
+
+    if (!le_cfg_NodeExists(iteratorRef, ""))
+    {
+        le_cfg_CancelTxn(iteratorRef);
+        return LE_NOT_FOUND;
+    }
+
+    pinState_Transition_t profile;
+    pinState_StartTransition(&profile, false);
+
+    int route;
+    if (ReadRoute(iteratorRef, "uart1", Uart1Routes, &route) == LE_OK)
+    {
+        routing_AddUart1(&profile, route);
+    }
+    if (ReadRoute(iteratorRef, "spi", SpiRoutes, &route) == LE_OK)
+    {
+        routing_AddSpi(&profile, route);
+    }
+    if (ReadRoute(iteratorRef, "uart2", Uart2Routes, &route) == LE_OK)
+    {
+        routing_AddUart2(&profile, route);
+    }
+    if (ReadRoute(iteratorRef, "sdio", SdioRoutes, &route) == LE_OK)
+    {
+        routing_AddSdio(&profile, route);
+    }
+    if (ReadRoute(iteratorRef, "audio", AudioRoutes, &route) == LE_OK)
+    {
+        routing_AddAudio(&profile, route);
+    }
+
+    for (int i = 0; i < NUM_ARRAY_MEMBERS(ResetEntries); i++)
+    {
+        if (le_cfg_NodeExists(iteratorRef, ResetEntries[i].node))
+        {
+            routing_AddReset(&profile,
+                             ResetEntries[i].target,
+                             le_cfg_GetBool(iteratorRef, ResetEntries[i].node, true));
+        }
+    }
+
+    le_cfg_CancelTxn(iteratorRef);
+
+    Merge(transitionPtr, &profile);
+
+    return LE_OK;
+}
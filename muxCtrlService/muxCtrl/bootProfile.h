@@ -0,0 +1,32 @@
+/**
+ * @file bootProfile.h
+ *
+ * Routing and reset states to start with, read from the config tree.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#ifndef MUXCTRL_BOOTPROFILE_H_INCLUDE_GUARD
+#define MUXCTRL_BOOTPROFILE_H_INCLUDE_GUARD
+
+#include "pinState.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the pin states selected by the boot profile in the config tree to a transition.  Pins that
+ * are already in the transition are left as they are.  Entries that are missing from the profile
+ * are skipped, as are entries with invalid values (which are also logged).
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_NOT_FOUND if there is no boot profile
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t bootProfile_Load
+(
+    pinState_Transition_t* transitionPtr  ///< Transition to add to
+);
+
+#endif // MUXCTRL_BOOTPROFILE_H_INCLUDE_GUARD
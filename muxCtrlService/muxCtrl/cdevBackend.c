@@ -0,0 +1,366 @@
+/**
+ * @file cdevBackend.c
+ *
+ * Backend that drives the expander lines directly through the Linux GPIO character device
+ * (uAPI v2), bypassing gpioExpanderServiceGreen.  Each expander is a gpiochip, and all the lines
+ * the service uses on it are held in a single line request, so a group write is one atomic
+ * GPIO_V2_LINE_SET_VALUES ioctl per expander.
+ *
+ * The chip device of each expander comes from an environment variable, MUXCTRL_GPIOCHIP_<n> for
+ * expander n (e.g. MUXCTRL_GPIOCHIP_1=/dev/gpiochip2).  The line offsets are the pin numbers on
+ * the expander, so the backend can be tried out on a gpio-sim or gpio-mockup chip with at least
+ * 16 lines in place of each expander.
+ *
+ * Lines are requested without a direction, so that requesting them does not disturb pins that a
+ * previous instance of the service left configured.  Active-low lines are requested as such, so
+ * line values are logical values like everywhere else in the service.
+ *
+ * The v2 uAPI was added in Linux 5.10.  To build the service against older kernel headers, set
+ * MUXCTRL_NO_CDEV_BACKEND=1 so that Component.cdef leaves this backend out.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+#include <linux/gpio.h>
+#include <sys/ioctl.h>
+
+#include "backend.h"
+
+#ifndef GPIO_V2_LINE_SET_VALUES_IOCTL
+#error "The cdev backend needs the GPIO v2 uAPI (Linux 5.10); set MUXCTRL_NO_CDEV_BACKEND=1"
+#endif
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Consumer label given to the requested lines.
+ */
+//--------------------------------------------------------------------------------------------------
+#define CONSUMER "muxCtrlService"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Lines of one expander.  Bit i of the masks stands for the i-th line of the request.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    int requestFd;                      ///< Line request, or -1 if the expander is not used
+    uint32_t numLines;                  ///< Number of lines in the request
+    pinState_Pin_t pins[PIN_COUNT];     ///< Pin of each line of the request
+    uint64_t activeLowMask;             ///< Lines that are active-low
+    uint64_t outputMask;                ///< Lines that are configured as outputs
+    uint64_t values;                    ///< Last values set on the output lines
+}
+Chip_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The expanders, indexed by expander number.
+ */
+//--------------------------------------------------------------------------------------------------
+static Chip_t Chips[PIN_STATE_MAX_EXPANDER + 1];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Position of each pin in the line request of its expander.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint8_t LineIndex[PIN_COUNT];
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fill in the line configuration of an expander from its active-low, output and value masks.
+ * Lines that are not outputs keep whatever direction they have.
+ */
+//--------------------------------------------------------------------------------------------------
+static void BuildConfig
+(
+    const Chip_t* chipPtr,
+    struct gpio_v2_line_config* configPtr
+)
+{
+    const struct
+    {
+        uint64_t mask;
+        uint64_t flags;
+    }
+    groups[] =
+    {
+        { chipPtr->outputMask & ~chipPtr->activeLowMask, GPIO_V2_LINE_FLAG_OUTPUT },
+        { chipPtr->outputMask & chipPtr->activeLowMask,
+          GPIO_V2_LINE_FLAG_OUTPUT | GPIO_V2_LINE_FLAG_ACTIVE_LOW },
+        { ~chipPtr->outputMask & chipPtr->activeLowMask, GPIO_V2_LINE_FLAG_ACTIVE_LOW },
+    };
+
+    memset(configPtr, 0, sizeof(*configPtr));
+
+    for (int i = 0; i < NUM_ARRAY_MEMBERS(groups); i++)
+    {
+        uint64_t mask = groups[i].mask & ((1ULL << chipPtr->numLines) - 1);
+        if (mask != 0)
+        {
+            struct gpio_v2_line_config_attribute* attrPtr =
+                &configPtr->attrs[configPtr->num_attrs++];
+            attrPtr->attr.id = GPIO_V2_LINE_ATTR_ID_FLAGS;
+            attrPtr->attr.flags = groups[i].flags;
+            attrPtr->mask = mask;
+        }
+    }
+
+    if (chipPtr->outputMask != 0)
+    {
+        struct gpio_v2_line_config_attribute* attrPtr = &configPtr->attrs[configPtr->num_attrs++];
+        attrPtr->attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+        attrPtr->attr.values = chipPtr->values;
+        attrPtr->mask = chipPtr->outputMask;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open the chip of an expander and request all the lines the service uses on it.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t OpenChip
+(
+    uint8_t expander
+)
+{
+    Chip_t* chipPtr = &Chips[expander];
+    char varName[32];
+
+    snprintf(varName, sizeof(varName), "MUXCTRL_GPIOCHIP_%u", expander);
+    const char* pathPtr = getenv(varName);
+    if (pathPtr == NULL)
+    {
+        LE_ERROR("%s is not set", varName);
+        return LE_FAULT;
+    }
+
+    int chipFd = open(pathPtr, O_RDWR | O_CLOEXEC);
+    if (chipFd < 0)
+    {
+        LE_ERROR("Failed to open %s (%m)", pathPtr);
+        return LE_FAULT;
+    }
+
+    struct gpio_v2_line_request request;
+    memset(&request, 0, sizeof(request));
+    le_utf8_Copy(request.consumer, CONSUMER, sizeof(request.consumer), NULL);
+    request.num_lines = chipPtr->numLines;
+
+    // Find out which lines are already outputs, so that their direction and value can be kept.
+    for (uint32_t i = 0; i < chipPtr->numLines; i++)
+    {
+        struct gpio_v2_line_info info;
+        memset(&info, 0, sizeof(info));
+        info.offset = pinState_GetExpanderPin(chipPtr->pins[i]);
+
+        if (ioctl(chipFd, GPIO_V2_GET_LINEINFO_IOCTL, &info) < 0)
+        {
+            LE_ERROR("Failed to get line %u of %s (%m)", info.offset, pathPtr);
+            close(chipFd);
+            return LE_FAULT;
+        }
+        if (info.flags & GPIO_V2_LINE_FLAG_OUTPUT)
+        {
+            chipPtr->outputMask |= (1ULL << i);
+        }
+
+        request.offsets[i] = info.offset;
+    }
+
+    // Request the lines as they are; outputs are only reconfigured once their values are known.
+    uint64_t outputMask = chipPtr->outputMask;
+    chipPtr->outputMask = 0;
+    BuildConfig(chipPtr, &request.config);
+    chipPtr->outputMask = outputMask;
+
+    int result = ioctl(chipFd, GPIO_V2_GET_LINE_IOCTL, &request);
+    close(chipFd);
+    if (result < 0)
+    {
+        LE_ERROR("Failed to request the lines of %s (%m)", pathPtr);
+        return LE_FAULT;
+    }
+    chipPtr->requestFd = request.fd;
+
+    struct gpio_v2_line_values lineValues = { .mask = chipPtr->outputMask };
+    if ((lineValues.mask != 0) &&
+        (ioctl(chipPtr->requestFd, GPIO_V2_LINE_GET_VALUES_IOCTL, &lineValues) < 0))
+    {
+        LE_ERROR("Failed to read the lines of %s (%m)", pathPtr);
+        close(chipPtr->requestFd);
+        chipPtr->requestFd = -1;
+        return LE_FAULT;
+    }
+    chipPtr->values = lineValues.bits & chipPtr->outputMask;
+
+    LE_INFO("Expander %u is %s (%u lines, outputs 0x%" PRIx64 ")",
+            expander, pathPtr, chipPtr->numLines, chipPtr->outputMask);
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Request the lines of all the expanders.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Init
+(
+    void
+)
+{
+    for (uint8_t expander = 0; expander <= PIN_STATE_MAX_EXPANDER; expander++)
+    {
+        Chips[expander].requestFd = -1;
+    }
+
+    for (int pin = 0; pin < PIN_COUNT; pin++)
+    {
+        Chip_t* chipPtr = &Chips[pinState_GetExpander(pin)];
+
+        LineIndex[pin] = chipPtr->numLines;
+        if (pinState_IsActiveLow(pin))
+        {
+            chipPtr->activeLowMask |= (1ULL << chipPtr->numLines);
+        }
+        chipPtr->pins[chipPtr->numLines++] = pin;
+    }
+
+    for (uint8_t expander = 0; expander <= PIN_STATE_MAX_EXPANDER; expander++)
+    {
+        if ((Chips[expander].numLines != 0) && (OpenChip(expander) != LE_OK))
+        {
+            return LE_FAULT;
+        }
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Configure a pin as an output with the given initial value.  This reconfigures the whole line
+ * request of the pin's expander, keeping the other lines as they are.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Configure
+(
+    pinState_Pin_t pin,
+    bool value
+)
+{
+    Chip_t* chipPtr = &Chips[pinState_GetExpander(pin)];
+    uint64_t bit = 1ULL << LineIndex[pin];
+
+    chipPtr->outputMask |= bit;
+    chipPtr->values = value ? (chipPtr->values | bit) : (chipPtr->values & ~bit);
+
+    struct gpio_v2_line_config config;
+    BuildConfig(chipPtr, &config);
+
+    if (ioctl(chipPtr->requestFd, GPIO_V2_LINE_SET_CONFIG_IOCTL, &config) < 0)
+    {
+        LE_ERROR("Failed to configure pin %s (%m)", pinState_GetName(pin));
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read back the state of a pin.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Read
+(
+    pinState_Pin_t pin,
+    bool* activePtr
+)
+{
+    Chip_t* chipPtr = &Chips[pinState_GetExpander(pin)];
+    uint64_t bit = 1ULL << LineIndex[pin];
+
+    if ((chipPtr->outputMask & bit) == 0)
+    {
+        return LE_UNAVAILABLE;
+    }
+
+    struct gpio_v2_line_values lineValues = { .mask = bit };
+    if (ioctl(chipPtr->requestFd, GPIO_V2_LINE_GET_VALUES_IOCTL, &lineValues) < 0)
+    {
+        LE_ERROR("Failed to read pin %s (%m)", pinState_GetName(pin));
+        return LE_FAULT;
+    }
+
+    *activePtr = ((lineValues.bits & bit) != 0);
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write a group of pins on one expander with a single, atomic ioctl.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Write
+(
+    uint8_t expander,
+    uint32_t pinMask,
+    uint32_t pinValues,
+    const pinState_Pin_t* pinOrderPtr
+)
+{
+    Chip_t* chipPtr = &Chips[expander];
+    struct gpio_v2_line_values lineValues = { 0 };
+
+    for (int pin = 0; pin < PIN_COUNT; pin++)
+    {
+        if (pinMask & (1 << pin))
+        {
+            LE_ASSERT(pinState_GetExpander(pin) == expander);
+
+            uint64_t bit = 1ULL << LineIndex[pin];
+            lineValues.mask |= bit;
+            if (pinValues & (1 << pin))
+            {
+                lineValues.bits |= bit;
+            }
+        }
+    }
+
+    if (ioctl(chipPtr->requestFd, GPIO_V2_LINE_SET_VALUES_IOCTL, &lineValues) < 0)
+    {
+        LE_ERROR("Failed to set lines 0x%" PRIx64 " of expander %u (%m)",
+                 (uint64_t)lineValues.mask, expander);
+        return LE_FAULT;
+    }
+
+    chipPtr->values = (chipPtr->values & ~lineValues.mask) | lineValues.bits;
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Backend that drives the expander lines directly through the Linux GPIO character device.
+ */
+//--------------------------------------------------------------------------------------------------
+const backend_Ops_t backend_Cdev =
+{
+    .name = "cdev",
+    .init = Init,
+    .configure = Configure,
+    .read = Read,
+    .write = Write,
+};
@@ -0,0 +1,204 @@
+/**
+ * @file gpioBackend.c
+ *
+ * Backend that drives each pin through its own le_gpio interface on gpioExpanderServiceGreen.
+ *
+ * le_gpio has no way to set several pins at once, so a group write is made one pin at a time, in
+ * the order in which the pins were added to the transition.
+ *
+ * The le_gpio interfaces are [manual-start], so that their sessions are opened on the worker
+ * thread that uses them rather than on the main thread.  They are also [optional], so that the
+ * service can run without gpioExpanderServiceGreen (e.g. on a host) when another backend is
+ * selected.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "backend.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Generates a function that configures one pin as a push-pull output.  The generated le_gpio
+ * functions each take their own polarity enum type, so this gives every pin a configuration
+ * function with the same signature.
+ */
+//--------------------------------------------------------------------------------------------------
+#define DEFINE_CONFIGURE_FUNC(pinName, polarity)                                                   \
+    static le_result_t Configure##pinName(bool value)                                              \
+    {                                                                                              \
+        return mangoh_gpioPin##pinName##_SetPushPullOutput(polarity, value);                       \
+    }
+
+DEFINE_CONFIGURE_FUNC(Uart1Enable,     MANGOH_GPIOPINUART1ENABLE_ACTIVE_LOW)
+DEFINE_CONFIGURE_FUNC(Uart1Select,     MANGOH_GPIOPINUART1SELECT_ACTIVE_HIGH)
+DEFINE_CONFIGURE_FUNC(SpiEnable,       MANGOH_GPIOPINSPIENABLE_ACTIVE_LOW)
+DEFINE_CONFIGURE_FUNC(SpiSelect,       MANGOH_GPIOPINSPISELECT_ACTIVE_HIGH)
+DEFINE_CONFIGURE_FUNC(Uart2Enable,     MANGOH_GPIOPINUART2ENABLE_ACTIVE_LOW)
+DEFINE_CONFIGURE_FUNC(Uart2Select,     MANGOH_GPIOPINUART2SELECT_ACTIVE_HIGH)
+DEFINE_CONFIGURE_FUNC(PcmEnable,       MANGOH_GPIOPINPCMENABLE_ACTIVE_LOW)
+DEFINE_CONFIGURE_FUNC(PcmSelect,       MANGOH_GPIOPINPCMSELECT_ACTIVE_HIGH)
+DEFINE_CONFIGURE_FUNC(SdioSelect,      MANGOH_GPIOPINSDIOSELECT_ACTIVE_HIGH)
+DEFINE_CONFIGURE_FUNC(PcmAnalogSelect, MANGOH_GPIOPINPCMANALOGSELECT_ACTIVE_HIGH)
+DEFINE_CONFIGURE_FUNC(Iot0Reset,       MANGOH_GPIOPINIOT0RESET_ACTIVE_LOW)
+DEFINE_CONFIGURE_FUNC(Iot1Reset,       MANGOH_GPIOPINIOT1RESET_ACTIVE_LOW)
+DEFINE_CONFIGURE_FUNC(Iot2Reset,       MANGOH_GPIOPINIOT2RESET_ACTIVE_LOW)
+DEFINE_CONFIGURE_FUNC(ArduinoReset,    MANGOH_GPIOPINARDUINORESET_ACTIVE_LOW)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fills in the table entry for one pin.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PIN_ENTRY(pinName)                                                                         \
+    {                                                                                              \
+        .connect = mangoh_gpioPin##pinName##_TryConnectService,                                    \
+        .configure = Configure##pinName,                                                           \
+        .activate = mangoh_gpioPin##pinName##_Activate,                                            \
+        .deactivate = mangoh_gpioPin##pinName##_Deactivate,                                        \
+        .isOutput = mangoh_gpioPin##pinName##_IsOutput,                                            \
+        .read = mangoh_gpioPin##pinName##_Read,                                                    \
+    }
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The le_gpio functions used to drive each of the pins.
+ */
+//--------------------------------------------------------------------------------------------------
+static const struct
+{
+    le_result_t (*connect)(void);
+    le_result_t (*configure)(bool value);
+    le_result_t (*activate)(void);
+    le_result_t (*deactivate)(void);
+    bool (*isOutput)(void);
+    bool (*read)(void);
+} Pins[PIN_COUNT] =
+{
+    [PIN_UART1_ENABLE]      = PIN_ENTRY(Uart1Enable),
+    [PIN_UART1_SELECT]      = PIN_ENTRY(Uart1Select),
+    [PIN_SPI_ENABLE]        = PIN_ENTRY(SpiEnable),
+    [PIN_SPI_SELECT]        = PIN_ENTRY(SpiSelect),
+    [PIN_UART2_ENABLE]      = PIN_ENTRY(Uart2Enable),
+    [PIN_UART2_SELECT]      = PIN_ENTRY(Uart2Select),
+    [PIN_PCM_ENABLE]        = PIN_ENTRY(PcmEnable),
+    [PIN_PCM_SELECT]        = PIN_ENTRY(PcmSelect),
+    [PIN_SDIO_SELECT]       = PIN_ENTRY(SdioSelect),
+    [PIN_PCM_ANALOG_SELECT] = PIN_ENTRY(PcmAnalogSelect),
+    [PIN_IOT0_RESET]        = PIN_ENTRY(Iot0Reset),
+    [PIN_IOT1_RESET]        = PIN_ENTRY(Iot1Reset),
+    [PIN_IOT2_RESET]        = PIN_ENTRY(Iot2Reset),
+    [PIN_ARDUINO_RESET]     = PIN_ENTRY(ArduinoReset),
+};
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Connect to the le_gpio interface of each pin.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Init
+(
+    void
+)
+{
+    for (int pin = 0; pin < PIN_COUNT; pin++)
+    {
+        le_result_t result = Pins[pin].connect();
+        if (result != LE_OK)
+        {
+            LE_ERROR("Unable to connect to the le_gpio interface of pin %s (%s)",
+                     pinState_GetName(pin), LE_RESULT_TXT(result));
+            return LE_FAULT;
+        }
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Configure a pin as a push-pull output with the given initial value.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Configure
+(
+    pinState_Pin_t pin,
+    bool value
+)
+{
+    return Pins[pin].configure(value);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read back the state of a pin.  The expander keeps its pins configured while the service
+ * restarts, so this tells a warm restart what the pins were left at.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Read
+(
+    pinState_Pin_t pin,
+    bool* activePtr
+)
+{
+    if (!Pins[pin].isOutput())
+    {
+        return LE_UNAVAILABLE;
+    }
+
+    *activePtr = Pins[pin].read();
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write a group of pins on one expander, one le_gpio call per pin in the order given.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Write
+(
+    uint8_t expander,
+    uint32_t pinMask,
+    uint32_t pinValues,
+    const pinState_Pin_t* pinOrderPtr
+)
+{
+    le_result_t result = LE_OK;
+    int numPins = __builtin_popcount(pinMask);
+
+    for (int i = 0; i < numPins; i++)
+    {
+        pinState_Pin_t pin = pinOrderPtr[i];
+        bool active = ((pinValues & (1 << pin)) != 0);
+        if ((active ? Pins[pin].activate() : Pins[pin].deactivate()) != LE_OK)
+        {
+            LE_ERROR("Failed to %s pin %s on expander %u",
+                     active ? "activate" : "deactivate", pinState_GetName(pin), expander);
+            result = LE_FAULT;
+        }
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Backend that drives each pin through its own le_gpio interface on gpioExpanderServiceGreen.
+ */
+//--------------------------------------------------------------------------------------------------
+const backend_Ops_t backend_Gpio =
+{
+    .name = "gpio",
+    .init = Init,
+    .configure = Configure,
+    .read = Read,
+    .write = Write,
+};
@@ -0,0 +1,392 @@
+/**
+ * @file i2cBackend.c
+ *
+ * Backend that owns the SX1509 expander registers itself, through /dev/i2c-N, instead of going
+ * through gpioExpanderServiceGreen.
+ *
+ * The backend keeps a shadow of the direction and data registers of each expander.  A group
+ * write changes the shadow and writes both data registers of the expander (RegDataB, RegDataA)
+ * in one I2C block write.  It then verifies them with one I2C block read, so a transition costs
+ * two bus transactions per expander however many pins it sets.
+ *
+ * Only SMBus I2C block transfers are used, so the backend also works against the kernel's
+ * i2c-stub module (e.g. "modprobe i2c-stub chip_addr=0x3e,0x3f,0x70"), which lets the number of
+ * bus transactions made per mux operation be checked without a board.
+ *
+ * Set up with environment variables:
+ *  - MUXCTRL_I2C_BUS: I2C adapter device the expanders are on (e.g. /dev/i2c-4)
+ *  - MUXCTRL_I2C_ADDR_<n>: address of expander n, to override the mangOH Green address
+ *
+ * On a mangOH Green the kernel's sx150x driver owns the expanders, so I2C_SLAVE fails with EBUSY
+ * until the driver is unbound from each of them (write the device name, e.g. 4-003e, to the
+ * driver's unbind file under /sys/bus/i2c/drivers/).  The backend doesn't use I2C_SLAVE_FORCE,
+ * which would change the registers behind the driver's back.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#include "backend.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * SX1509 registers.  Each register pair is bank B (pins 8-15) followed by bank A (pins 0-7), so
+ * one auto-incrementing block transfer covers all 16 pins.
+ */
+//--------------------------------------------------------------------------------------------------
+#define REG_DIR_B   0x0E    ///< Direction: 1 for input, 0 for output
+#define REG_DATA_B  0x10    ///< Data: output values when written, pin levels when read
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * I2C address of each expander on the mangOH Green, indexed by expander number.
+ */
+//--------------------------------------------------------------------------------------------------
+static const uint8_t DefaultAddress[PIN_STATE_MAX_EXPANDER + 1] =
+{
+    [1] = 0x3E,
+    [2] = 0x3F,
+    [3] = 0x70,
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * State of one expander.  Register values are physical levels; active-low pins are inverted on
+ * the way in and out.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    int fd;             ///< Adapter file descriptor bound to the expander, or -1 if unused
+    uint16_t dir;       ///< Shadow of the direction registers
+    uint16_t data;      ///< Shadow of the data registers
+}
+Expander_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The expanders, indexed by expander number.
+ */
+//--------------------------------------------------------------------------------------------------
+static Expander_t Expanders[PIN_STATE_MAX_EXPANDER + 1];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of I2C transactions made.  Updated on the worker thread and read from the main thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t TransactionCount;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read or write a register pair of an expander with one I2C block transfer.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Transfer
+(
+    uint8_t expander,
+    bool write,             ///< true to write the registers, false to read them
+    uint8_t reg,            ///< First register of the pair
+    uint16_t* valuePtr      ///< [IN/OUT] Register pair value
+)
+{
+    union i2c_smbus_data data;
+    struct i2c_smbus_ioctl_data args =
+    {
+        .read_write = write ? I2C_SMBUS_WRITE : I2C_SMBUS_READ,
+        .command = reg,
+        .size = I2C_SMBUS_I2C_BLOCK_DATA,
+        .data = &data,
+    };
+
+    data.block[0] = 2;
+    if (write)
+    {
+        data.block[1] = *valuePtr >> 8;
+        data.block[2] = *valuePtr & 0xFF;
+    }
+
+    __atomic_add_fetch(&TransactionCount, 1, __ATOMIC_RELAXED);
+
+    if (ioctl(Expanders[expander].fd, I2C_SMBUS, &args) < 0)
+    {
+        LE_ERROR("Failed to %s register 0x%02x of expander %u (%m)",
+                 write ? "write" : "read", reg, expander);
+        return LE_FAULT;
+    }
+
+    if (!write)
+    {
+        *valuePtr = (data.block[1] << 8) | data.block[2];
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the register mask of the active-low pins of an expander.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint16_t ActiveLowMask
+(
+    uint8_t expander
+)
+{
+    uint32_t pinMask = 0;
+
+    for (int pin = 0; pin < PIN_COUNT; pin++)
+    {
+        if ((pinState_GetExpander(pin) == expander) && pinState_IsActiveLow(pin))
+        {
+            pinMask |= (1 << pin);
+        }
+    }
+
+    uint16_t regMask;
+    uint16_t regValues;
+    backend_ToRegister(expander, pinMask, pinMask, &regMask, &regValues);
+
+    return regMask;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write the data registers of an expander from its shadow and read them back to check them.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t WriteData
+(
+    uint8_t expander,
+    uint16_t checkMask      ///< Register bits that must read back as written
+)
+{
+    Expander_t* expPtr = &Expanders[expander];
+    uint16_t readBack;
+
+    if ((Transfer(expander, true, REG_DATA_B, &expPtr->data) != LE_OK) ||
+        (Transfer(expander, false, REG_DATA_B, &readBack) != LE_OK))
+    {
+        return LE_FAULT;
+    }
+
+    if ((readBack ^ expPtr->data) & checkMask)
+    {
+        LE_ERROR("Expander %u data reads back as 0x%04x instead of 0x%04x (mask 0x%04x)",
+                 expander, readBack, expPtr->data, checkMask);
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Close the adapter file descriptors of all the expanders.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CloseExpanders
+(
+    void
+)
+{
+    for (uint8_t expander = 0; expander <= PIN_STATE_MAX_EXPANDER; expander++)
+    {
+        if (Expanders[expander].fd >= 0)
+        {
+            close(Expanders[expander].fd);
+            Expanders[expander].fd = -1;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open the adapter for each expander that has pins on it and load the register shadows.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Init
+(
+    void
+)
+{
+    const char* busPtr = getenv("MUXCTRL_I2C_BUS");
+    if (busPtr == NULL)
+    {
+        LE_ERROR("MUXCTRL_I2C_BUS is not set");
+        return LE_FAULT;
+    }
+
+    for (uint8_t expander = 0; expander <= PIN_STATE_MAX_EXPANDER; expander++)
+    {
+        Expanders[expander].fd = -1;
+    }
+
+    for (int pin = 0; pin < PIN_COUNT; pin++)
+    {
+        uint8_t expander = pinState_GetExpander(pin);
+        Expander_t* expPtr = &Expanders[expander];
+
+        if (expPtr->fd >= 0)
+        {
+            continue;
+        }
+
+        char varName[32];
+        snprintf(varName, sizeof(varName), "MUXCTRL_I2C_ADDR_%u", expander);
+        const char* addrPtr = getenv(varName);
+        long address = (addrPtr != NULL) ? strtol(addrPtr, NULL, 0) : DefaultAddress[expander];
+
+        expPtr->fd = open(busPtr, O_RDWR | O_CLOEXEC);
+        if (expPtr->fd < 0)
+        {
+            LE_ERROR("Failed to open %s (%m)", busPtr);
+            CloseExpanders();
+            return LE_FAULT;
+        }
+        if (ioctl(expPtr->fd, I2C_SLAVE, address) < 0)
+        {
+            // EBUSY means a kernel driver (sx150x) is bound to the expander.
+            LE_ERROR("Failed to address expander %u at 0x%02lx (%m)", expander, address);
+            CloseExpanders();
+            return LE_FAULT;
+        }
+
+        if ((Transfer(expander, false, REG_DIR_B, &expPtr->dir) != LE_OK) ||
+            (Transfer(expander, false, REG_DATA_B, &expPtr->data) != LE_OK))
+        {
+            CloseExpanders();
+            return LE_FAULT;
+        }
+
+        LE_INFO("Expander %u is at 0x%02lx on %s (dir 0x%04x, data 0x%04x)",
+                expander, address, busPtr, expPtr->dir, expPtr->data);
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Configure a pin as an output with the given initial value.  The data register is written
+ * before the direction register, so the pin comes up at the right level.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Configure
+(
+    pinState_Pin_t pin,
+    bool value
+)
+{
+    uint8_t expander = pinState_GetExpander(pin);
+    Expander_t* expPtr = &Expanders[expander];
+    uint16_t bit = 1 << pinState_GetExpanderPin(pin);
+
+    if (value != pinState_IsActiveLow(pin))
+    {
+        expPtr->data |= bit;
+    }
+    else
+    {
+        expPtr->data &= ~bit;
+    }
+
+    if (WriteData(expander, bit) != LE_OK)
+    {
+        return LE_FAULT;
+    }
+
+    expPtr->dir &= ~bit;
+
+    return Transfer(expander, true, REG_DIR_B, &expPtr->dir);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read back the state of a pin from the register shadow, which was loaded from the expander when
+ * the backend was initialized.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Read
+(
+    pinState_Pin_t pin,
+    bool* activePtr
+)
+{
+    const Expander_t* expPtr = &Expanders[pinState_GetExpander(pin)];
+    uint16_t bit = 1 << pinState_GetExpanderPin(pin);
+
+    if (expPtr->dir & bit)
+    {
+        return LE_UNAVAILABLE;
+    }
+
+    *activePtr = (((expPtr->data & bit) != 0) != pinState_IsActiveLow(pin));
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write a group of pins on one expander with a single block write, and verify it with a single
+ * block read.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Write
+(
+    uint8_t expander,
+    uint32_t pinMask,
+    uint32_t pinValues,
+    const pinState_Pin_t* pinOrderPtr
+)
+{
+    Expander_t* expPtr = &Expanders[expander];
+    uint16_t regMask;
+    uint16_t regValues;
+
+    backend_ToRegister(expander, pinMask, pinValues, &regMask, &regValues);
+    regValues ^= (ActiveLowMask(expander) & regMask);
+
+    expPtr->data = (expPtr->data & ~regMask) | regValues;
+
+    return WriteData(expander, regMask);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of I2C transactions made so far.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t GetTransactionCount
+(
+    void
+)
+{
+    return __atomic_load_n(&TransactionCount, __ATOMIC_RELAXED);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Backend that drives the SX1509 expander registers directly over I2C.
+ */
+//--------------------------------------------------------------------------------------------------
+const backend_Ops_t backend_I2c =
+{
+    .name = "i2c",
+    .init = Init,
+    .configure = Configure,
+    .read = Read,
+    .write = Write,
+    .getTransactionCount = GetTransactionCount,
+};
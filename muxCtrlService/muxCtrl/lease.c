@@ -0,0 +1,243 @@
+/**
+ * @file lease.c
+ *
+ * Leases that give one client exclusive control of a mux, and the BusReleased event that tells
+ * waiting clients when a lease is given up.
+ *
+ * UART 1 and SPI are each shared between IoT slots 0 and 1.  A client in the middle of a transfer
+ * takes the lease on the mux so that another client can't switch the bus away from it; requests
+ * from other clients that would move a leased mux are refused by the request queue.  A client
+ * that finds the lease taken waits for BusReleased rather than polling.
+ *
+ * Leases belong to client sessions, so they are given up when the client goes away.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "lease.h"
+#include "sessionHandlers.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of groups that can be leased: the muxes, but not the reset lines.
+ */
+//--------------------------------------------------------------------------------------------------
+#define NUM_LEASES (MANGOH_MUXCTRL_MUX_AUDIO + 1)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Session holding the lease on each mux, or NULL if it is free.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_msg_SessionRef_t Holders[NUM_LEASES];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Event used to report that a lease has been given up.  The report is the mux group.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_event_Id_t BusReleasedEventId;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Registered BusReleased handlers.
+ */
+//--------------------------------------------------------------------------------------------------
+static sessionHandlers_List_t Handlers;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pass a released lease on to a client's handler.
+ */
+//--------------------------------------------------------------------------------------------------
+static void FirstLayerBusReleasedHandler
+(
+    void* reportPtr,
+    void* secondLayerHandlerFunc
+)
+{
+    const mangoh_muxCtrl_MuxGroup_t* groupPtr = reportPtr;
+    mangoh_muxCtrl_BusReleasedHandlerFunc_t clientHandlerFunc = secondLayerHandlerFunc;
+
+    clientHandlerFunc(*groupPtr, le_event_GetContextPtr());
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Free a lease and tell the clients waiting for it.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Free
+(
+    mangoh_muxCtrl_MuxGroup_t group
+)
+{
+    Holders[group] = NULL;
+    le_event_Report(BusReleasedEventId, &group, sizeof(group));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Create the BusReleased event.
+ */
+//--------------------------------------------------------------------------------------------------
+void lease_Init
+(
+    void
+)
+{
+    BusReleasedEventId = le_event_CreateId("Bus released", sizeof(mangoh_muxCtrl_MuxGroup_t));
+    sessionHandlers_Init(&Handlers, "bus released", BusReleasedEventId,
+                         FirstLayerBusReleasedHandler);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Take the lease on a mux for a client session.
+ *
+ * @return
+ *      - LE_OK if the session holds the lease, including if it already did
+ *      - LE_BUSY if another session holds it
+ *      - LE_BAD_PARAMETER if the group is not a mux
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t lease_Acquire
+(
+    mangoh_muxCtrl_MuxGroup_t group,
+    le_msg_SessionRef_t sessionRef
+)
+{
+    if ((group < 0) || (group >= NUM_LEASES))
+    {
+        LE_ERROR("Mux group %d can't be leased", group);
+        return LE_BAD_PARAMETER;
+    }
+
+    if ((Holders[group] != NULL) && (Holders[group] != sessionRef))
+    {
+        return LE_BUSY;
+    }
+
+    Holders[group] = sessionRef;
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Give up the lease a client session holds on a mux, and report BusReleased.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_NOT_PERMITTED if the session does not hold the lease
+ *      - LE_BAD_PARAMETER if the group is not a mux
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t lease_Release
+(
+    mangoh_muxCtrl_MuxGroup_t group,
+    le_msg_SessionRef_t sessionRef
+)
+{
+    if ((group < 0) || (group >= NUM_LEASES))
+    {
+        LE_ERROR("Mux group %d can't be leased", group);
+        return LE_BAD_PARAMETER;
+    }
+
+    if ((sessionRef == NULL) || (Holders[group] != sessionRef))
+    {
+        return LE_NOT_PERMITTED;
+    }
+
+    Free(group);
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether anyone holds the lease on a group.
+ */
+//--------------------------------------------------------------------------------------------------
+bool lease_IsHeld
+(
+    mangoh_muxCtrl_MuxGroup_t group
+)
+{
+    return (group >= 0) && (group < NUM_LEASES) && (Holders[group] != NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether a client session may change a group: nobody holds its lease, or the session
+ * does.  A NULL session (one that has closed) may only change groups that are not leased.
+ */
+//--------------------------------------------------------------------------------------------------
+bool lease_IsAllowed
+(
+    mangoh_muxCtrl_MuxGroup_t group,
+    le_msg_SessionRef_t sessionRef
+)
+{
+    return !lease_IsHeld(group) || (Holders[group] == sessionRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Register a BusReleased handler for the client of the message being handled.
+ */
+//--------------------------------------------------------------------------------------------------
+mangoh_muxCtrl_BusReleasedHandlerRef_t lease_AddHandler
+(
+    mangoh_muxCtrl_BusReleasedHandlerFunc_t handlerPtr,  ///< Handler to call
+    void* contextPtr                                     ///< Passed to the handler
+)
+{
+    return (mangoh_muxCtrl_BusReleasedHandlerRef_t)sessionHandlers_Add(&Handlers, handlerPtr,
+                                                                       contextPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove a BusReleased handler.
+ */
+//--------------------------------------------------------------------------------------------------
+void lease_RemoveHandler
+(
+    mangoh_muxCtrl_BusReleasedHandlerRef_t handlerRef  ///< Handler to remove
+)
+{
+    sessionHandlers_Remove(&Handlers, (le_event_HandlerRef_t)handlerRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release the leases and remove the BusReleased handlers of a client session that has closed.
+ */
+//--------------------------------------------------------------------------------------------------
+void lease_SessionClosed
+(
+    le_msg_SessionRef_t sessionRef
+)
+{
+    // Remove the session's own handlers first; it isn't waiting for the leases it held.
+    sessionHandlers_RemoveSession(&Handlers, sessionRef);
+
+    for (int group = 0; group < NUM_LEASES; group++)
+    {
+        if (Holders[group] == sessionRef)
+        {
+            LE_INFO("Releasing the lease on mux group %d held by a closed session", group);
+            Free(group);
+        }
+    }
+}
@@ -0,0 +1,110 @@
+/**
+ * @file lease.h
+ *
+ * Leases that give one client exclusive control of a mux, and the BusReleased event that tells
+ * waiting clients when a lease is given up.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#ifndef MUXCTRL_LEASE_H_INCLUDE_GUARD
+#define MUXCTRL_LEASE_H_INCLUDE_GUARD
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Create the BusReleased event.
+ */
+//--------------------------------------------------------------------------------------------------
+void lease_Init
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Take the lease on a mux for a client session.
+ *
+ * @return
+ *      - LE_OK if the session holds the lease, including if it already did
+ *      - LE_BUSY if another session holds it
+ *      - LE_BAD_PARAMETER if the group is not a mux
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t lease_Acquire
+(
+    mangoh_muxCtrl_MuxGroup_t group,
+    le_msg_SessionRef_t sessionRef
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Give up the lease a client session holds on a mux, and report BusReleased.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_NOT_PERMITTED if the session does not hold the lease
+ *      - LE_BAD_PARAMETER if the group is not a mux
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t lease_Release
+(
+    mangoh_muxCtrl_MuxGroup_t group,
+    le_msg_SessionRef_t sessionRef
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether anyone holds the lease on a group.
+ */
+//--------------------------------------------------------------------------------------------------
+bool lease_IsHeld
+(
+    mangoh_muxCtrl_MuxGroup_t group
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether a client session may change a group: nobody holds its lease, or the session
+ * does.  A NULL session (one that has closed) may only change groups that are not leased.
+ */
+//--------------------------------------------------------------------------------------------------
+bool lease_IsAllowed
+(
+    mangoh_muxCtrl_MuxGroup_t group,
+    le_msg_SessionRef_t sessionRef
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Register a BusReleased handler for the client of the message being handled.
+ */
+//--------------------------------------------------------------------------------------------------
+mangoh_muxCtrl_BusReleasedHandlerRef_t lease_AddHandler
+(
+    mangoh_muxCtrl_BusReleasedHandlerFunc_t handlerPtr,  ///< Handler to call
+    void* contextPtr                                     ///< Passed to the handler
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove a BusReleased handler.
+ */
+//--------------------------------------------------------------------------------------------------
+void lease_RemoveHandler
+(
+    mangoh_muxCtrl_BusReleasedHandlerRef_t handlerRef  ///< Handler to remove
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release the leases and remove the BusReleased handlers of a client session that has closed.
+ */
+//--------------------------------------------------------------------------------------------------
+void lease_SessionClosed
+(
+    le_msg_SessionRef_t sessionRef
+);
+
+#endif // MUXCTRL_LEASE_H_INCLUDE_GUARD
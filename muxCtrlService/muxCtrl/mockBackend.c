@@ -0,0 +1,247 @@
+/**
+ * @file mockBackend.c
+ *
+ * Backend for tests and benchmarks on a plain Linux host.  It models the expanders with the stub
+ * backend's stand-in registers, and in addition:
+ *  - records every call, with a time stamp, in a log file if MUXCTRL_MOCK_LOG names one;
+ *  - sleeps MUXCTRL_MOCK_LATENCY_US microseconds in every call, to stand in for the bus;
+ *  - fails every Nth call that changes a pin if MUXCTRL_MOCK_FAIL_EVERY is set to N.
+ *
+ * Each line of the log is "<seconds>.<microseconds> <call> <arguments> <result>", e.g.
+ * "12.000345 write exp=1 mask=0x00000003 values=0x00000001 LE_OK".
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "backend.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Call log, or NULL if calls are not logged.
+ */
+//--------------------------------------------------------------------------------------------------
+static FILE* LogFile;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Simulated latency of each call.
+ */
+//--------------------------------------------------------------------------------------------------
+static struct timespec Latency;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fail every FailEvery-th call that changes a pin (0 to never fail), and the number of such calls
+ * so far.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t FailEvery;
+static uint32_t ChangeCount;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Simulate the latency of a call.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Delay
+(
+    void
+)
+{
+    if ((Latency.tv_sec != 0) || (Latency.tv_nsec != 0))
+    {
+        struct timespec remaining = Latency;
+        while (nanosleep(&remaining, &remaining) != 0)
+        {
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decide whether a call that changes a pin should fail.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool ShouldFail
+(
+    void
+)
+{
+    uint32_t count = __atomic_add_fetch(&ChangeCount, 1, __ATOMIC_RELAXED);
+
+    return ((FailEvery != 0) && ((count % FailEvery) == 0));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Record a call in the log.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Record
+(
+    le_result_t result,
+    const char* format,
+    ...
+)
+{
+    if (LogFile == NULL)
+    {
+        return;
+    }
+
+    le_clk_Time_t now = le_clk_GetRelativeTime();
+    va_list args;
+
+    fprintf(LogFile, "%ld.%06ld ", (long)now.sec, (long)now.usec);
+    va_start(args, format);
+    vfprintf(LogFile, format, args);
+    va_end(args);
+    fprintf(LogFile, " %s\n", LE_RESULT_TXT(result));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the mock's settings from the environment and open the call log.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Init
+(
+    void
+)
+{
+    const char* valuePtr = getenv("MUXCTRL_MOCK_LATENCY_US");
+    if (valuePtr != NULL)
+    {
+        unsigned long latencyUs = strtoul(valuePtr, NULL, 0);
+        Latency.tv_sec = latencyUs / 1000000;
+        Latency.tv_nsec = (latencyUs % 1000000) * 1000;
+    }
+
+    valuePtr = getenv("MUXCTRL_MOCK_FAIL_EVERY");
+    if (valuePtr != NULL)
+    {
+        FailEvery = strtoul(valuePtr, NULL, 0);
+    }
+
+    valuePtr = getenv("MUXCTRL_MOCK_LOG");
+    if (valuePtr != NULL)
+    {
+        LogFile = fopen(valuePtr, "w");
+        if (LogFile == NULL)
+        {
+            LE_ERROR("Failed to open the mock call log %s (%m)", valuePtr);
+            return LE_FAULT;
+        }
+        setvbuf(LogFile, NULL, _IOLBF, 0);
+    }
+
+    LE_INFO("Mock backend: latency %ld us, failing every %u changes, log %s",
+            (long)(Latency.tv_sec * 1000000 + Latency.tv_nsec / 1000),
+            FailEvery,
+            (valuePtr != NULL) ? valuePtr : "off");
+
+    Record(LE_OK, "init");
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Configure a pin as an output with the given initial value.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Configure
+(
+    pinState_Pin_t pin,
+    bool value
+)
+{
+    Delay();
+
+    le_result_t result = ShouldFail() ? LE_FAULT : backend_Stub.configure(pin, value);
+
+    Record(result, "configure pin=%s value=%d", pinState_GetName(pin), value);
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read back the state of a pin.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Read
+(
+    pinState_Pin_t pin,
+    bool* activePtr
+)
+{
+    Delay();
+
+    le_result_t result = backend_Stub.read(pin, activePtr);
+
+    Record(result, "read pin=%s value=%d", pinState_GetName(pin),
+           (result == LE_OK) ? *activePtr : -1);
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write a group of pins on one expander.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Write
+(
+    uint8_t expander,
+    uint32_t pinMask,
+    uint32_t pinValues,
+    const pinState_Pin_t* pinOrderPtr
+)
+{
+    Delay();
+
+    le_result_t result = ShouldFail() ? LE_FAULT :
+                                        backend_Stub.write(expander, pinMask, pinValues,
+                                                           pinOrderPtr);
+
+    Record(result, "write exp=%u mask=0x%08x values=0x%08x", expander, pinMask, pinValues);
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of calls that changed a pin, which the mock counts as bus transactions.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t GetTransactionCount
+(
+    void
+)
+{
+    return __atomic_load_n(&ChangeCount, __ATOMIC_RELAXED);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Backend for tests and benchmarks on a plain Linux host.
+ */
+//--------------------------------------------------------------------------------------------------
+const backend_Ops_t backend_Mock =
+{
+    .name = "mock",
+    .init = Init,
+    .configure = Configure,
+    .read = Read,
+    .write = Write,
+    .getTransactionCount = GetTransactionCount,
+};
@@ -18,585 +18,2338 @@
 #include "legato.h"
 #include "interfaces.h"
 
+#include "pinState.h"
+#include "worker.h"
+#include "routing.h"
+#include "resetPulse.h"
+#include "muxState.h"
+#include "bootProfile.h"
+#include "stats.h"
+#include "trace.h"
+#include "lease.h"
+#include "scheduler.h"
+
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Disable UART 1
- *
- * @return
- *      - LE_FAULT
- *      - LE_OK
+ * Maximum number of requests that can be waiting to run.  Further requests are rejected with
+ * LE_BUSY rather than letting the queue (and the time each client waits) grow without bound.
+ */
+//--------------------------------------------------------------------------------------------------
+#define REQUEST_QUEUE_SIZE 32
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Function called when an operation has completed.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t mangoh_muxCtrl_IotAllUart1Off
+typedef void (*DoneFunc_t)
 (
-    void
-)
+    le_result_t result,  ///< Result of the operation
+    void* contextPtr     ///< Context pointer passed to StartOperation()
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Function that sends the result of a request back to the client.  The generated Respond function
+ * of every API function that only returns an le_result_t has this signature.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*RespondFunc_t)
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef,
+    le_result_t result
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Kinds of client request.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    REQUEST_OPERATION,      ///< Run one operation
+    REQUEST_PULSE,          ///< Pulse a reset
+    REQUEST_CONFIGURATION,  ///< Apply a complete routing
+    REQUEST_SEQUENCE        ///< Run a sequence of operations
+}
+RequestType_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * A client request.  Requests are queued and run one at a time, in the order they were received.
+ * A reset pulse only holds the queue until its target is in reset.
+ *
+ * Synchronous requests are answered through their command reference once they are complete;
+ * asynchronous requests are answered straight away and their completion handler is called once
+ * they are complete.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
 {
-    if (mangoh_gpioPinUart1Enable_Deactivate() != LE_OK)
+    le_sls_Link_t link;                         ///< Link in RequestQueue
+    RequestType_t type;                         ///< What was requested
+    union
     {
-        LE_ERROR("Failed to disable UART 1");
-        return LE_FAULT;
-    }
+        mangoh_muxCtrl_Operation_t op;          ///< REQUEST_OPERATION: operation to run
+        mangoh_muxCtrl_ResetTarget_t target;    ///< REQUEST_PULSE: target to reset
+        struct
+        {
+            mangoh_muxCtrl_Uart1Route_t uart1;
+            mangoh_muxCtrl_SpiRoute_t spi;
+            mangoh_muxCtrl_Uart2Route_t uart2;
+            mangoh_muxCtrl_SdioRoute_t sdio;
+            mangoh_muxCtrl_AudioRoute_t audio;
+        } config;                               ///< REQUEST_CONFIGURATION: routing to apply
+        struct
+        {
+            mangoh_muxCtrl_Operation_t ops[MANGOH_MUXCTRL_MAX_SEQUENCE_LEN];
+            size_t numOps;
+            size_t current;                     ///< Index of the running operation
+        } sequence;                             ///< REQUEST_SEQUENCE: operations to run
+    } params;
+    mangoh_muxCtrl_Operation_t runningOp;       ///< Operation being committed, for error messages
+    DoneFunc_t opDoneFunc;                      ///< Called when runningOp is complete
+    le_clk_Time_t queuedTime;                   ///< When the request was queued
+    le_clk_Time_t startTime;                    ///< When the request started running
+    le_sls_List_t coalesced;                    ///< Superseded requests that share this result
+    le_msg_SessionRef_t sessionRef;             ///< Client session, or NULL once it has closed
+    pid_t clientPid;                            ///< Client process, for the trace
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef;       ///< Command to respond to (synchronous requests)
+    RespondFunc_t respondFunc;                  ///< Used to respond to cmdRef
+    mangoh_muxCtrl_CompletionHandlerFunc_t handlerPtr; ///< Completion handler (async requests)
+    void* contextPtr;                           ///< Context of handlerPtr
+}
+Request_t;
 
-    return LE_OK;
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pool of Request_t.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t RequestPool;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Requests waiting to be run, and the request that is running.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_sls_List_t RequestQueue = LE_SLS_LIST_INIT;
+static Request_t* ActiveRequestPtr;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reset pulse requests that have put their target in reset and let the queue move on, and are
+ * waiting for the end of the pulse.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_sls_List_t PulseRequests = LE_SLS_LIST_INIT;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * true while ProcessQueue() is running, so requests that complete straight away don't recurse
+ * into it.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool ProcessingQueue;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Request queue statistics.  Times are in microseconds; the wait time is the time spent in the
+ * queue and the service time is the time from starting a request to completing it.
+ */
+//--------------------------------------------------------------------------------------------------
+static struct
+{
+    uint32_t depth;             ///< Number of requests in RequestQueue
+    uint32_t maxDepth;          ///< Largest depth seen
+    uint32_t rejected;          ///< Requests rejected because the queue was full
+    uint32_t completed;         ///< Requests completed
+    uint64_t totalWaitUs;
+    uint32_t maxWaitUs;
+    uint64_t totalServiceUs;
+    uint32_t maxServiceUs;
 }
+QueueStats;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Enable UART 1 on IoT slot 0
+ * How long (in microseconds) a mux operation waits after it is queued for later requests that
+ * would supersede it.  0 disables coalescing.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t CoalescingWindowUs;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Timer that holds the active request for the rest of its coalescing window.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_timer_Ref_t CoalescingTimer;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of requests whose transition was skipped because a later request superseded them.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t CoalescedCount;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * What each operation does, used in error messages.
+ */
+//--------------------------------------------------------------------------------------------------
+static const char* const OperationDescriptions[] =
+{
+    [MANGOH_MUXCTRL_OP_IOT_ALL_UART1_OFF]           = "disable UART 1",
+    [MANGOH_MUXCTRL_OP_IOT0_UART1_ON]               = "enable UART 1 on IoT slot 0",
+    [MANGOH_MUXCTRL_OP_IOT1_UART1_ON]               = "enable UART 1 on IoT slot 1",
+    [MANGOH_MUXCTRL_OP_IOT_ALL_SPI_OFF]             = "disable SPI",
+    [MANGOH_MUXCTRL_OP_IOT0_SPI1_ON]                = "enable SPI on IoT slot 0",
+    [MANGOH_MUXCTRL_OP_IOT1_SPI1_ON]                = "enable SPI on IoT slot 1",
+    [MANGOH_MUXCTRL_OP_IOT_ALL_UART2_OFF]           = "disable UART 2",
+    [MANGOH_MUXCTRL_OP_IOT2_UART2_ON]               = "enable UART 2 on IoT slot 2",
+    [MANGOH_MUXCTRL_OP_UART2_DEBUG_ON]              = "enable UART 2 on the debug port",
+    [MANGOH_MUXCTRL_OP_SDIO_SEL_MICRO_SD]           = "select MicroSD slot for SDIO",
+    [MANGOH_MUXCTRL_OP_SDIO_SEL_IOT0]               = "select IoT slot 0 for SDIO",
+    [MANGOH_MUXCTRL_OP_AUDIO_DISABLE]               = "disable audio",
+    [MANGOH_MUXCTRL_OP_AUDIO_SELECT_IOT0_CODEC]     = "route audio via the IoT slot 0 codec",
+    [MANGOH_MUXCTRL_OP_AUDIO_SELECT_ONBOARD_CODEC]  = "route audio via the onboard codec",
+    [MANGOH_MUXCTRL_OP_AUDIO_SELECT_INTERNAL_CODEC] = "route audio via the internal codec",
+    [MANGOH_MUXCTRL_OP_IOT_SLOT0_DEASSERT_RESET]    = "take IoT slot 0 out of reset",
+    [MANGOH_MUXCTRL_OP_IOT_SLOT1_DEASSERT_RESET]    = "take IoT slot 1 out of reset",
+    [MANGOH_MUXCTRL_OP_IOT_SLOT2_DEASSERT_RESET]    = "take IoT slot 2 out of reset",
+    [MANGOH_MUXCTRL_OP_ARDUINO_ASSERT_RESET]        = "put Arduino reset pin low",
+    [MANGOH_MUXCTRL_OP_ARDUINO_DEASSERT_RESET]      = "put Arduino reset pin high",
+    [MANGOH_MUXCTRL_OP_ARDUINO_RESET]               = "reset Arduino",
+};
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the pin changes made by an operation to a transition.  The Arduino reset pulse can't be
+ * expressed as a single transition and is handled by StartOperation().
  *
  * @return
- *      - LE_FAULT
  *      - LE_OK
+ *      - LE_BAD_PARAMETER if the operation is not valid
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t mangoh_muxCtrl_Iot0Uart1On
+static le_result_t AddOperation
 (
-    void
+    pinState_Transition_t* transitionPtr,  ///< Transition to add to
+    mangoh_muxCtrl_Operation_t op          ///< Operation
 )
 {
-    if (mangoh_gpioPinUart1Select_Activate() != LE_OK)
+    switch (op)
     {
-        LE_ERROR("Failed to select IoT slot 0 for UART 1");
-        return LE_FAULT;
-    }
+        case MANGOH_MUXCTRL_OP_IOT_ALL_UART1_OFF:
+            return routing_AddUart1(transitionPtr, MANGOH_MUXCTRL_UART1_OFF);
+        case MANGOH_MUXCTRL_OP_IOT0_UART1_ON:
+            return routing_AddUart1(transitionPtr, MANGOH_MUXCTRL_UART1_IOT0);
+        case MANGOH_MUXCTRL_OP_IOT1_UART1_ON:
+            return routing_AddUart1(transitionPtr, MANGOH_MUXCTRL_UART1_IOT1);
 
-    if (mangoh_gpioPinUart1Enable_Activate() != LE_OK)
-    {
-        LE_ERROR("Failed to enable UART 1");
-        return LE_FAULT;
-    }
+        case MANGOH_MUXCTRL_OP_IOT_ALL_SPI_OFF:
+            return routing_AddSpi(transitionPtr, MANGOH_MUXCTRL_SPI_OFF);
+        case MANGOH_MUXCTRL_OP_IOT0_SPI1_ON:
+            return routing_AddSpi(transitionPtr, MANGOH_MUXCTRL_SPI_IOT0);
+        case MANGOH_MUXCTRL_OP_IOT1_SPI1_ON:
+            return routing_AddSpi(transitionPtr, MANGOH_MUXCTRL_SPI_IOT1);
 
-    return LE_OK;
+        case MANGOH_MUXCTRL_OP_IOT_ALL_UART2_OFF:
+            return routing_AddUart2(transitionPtr, MANGOH_MUXCTRL_UART2_OFF);
+        case MANGOH_MUXCTRL_OP_IOT2_UART2_ON:
+            return routing_AddUart2(transitionPtr, MANGOH_MUXCTRL_UART2_IOT2);
+        case MANGOH_MUXCTRL_OP_UART2_DEBUG_ON:
+            return routing_AddUart2(transitionPtr, MANGOH_MUXCTRL_UART2_DEBUG);
+
+        case MANGOH_MUXCTRL_OP_SDIO_SEL_MICRO_SD:
+            return routing_AddSdio(transitionPtr, MANGOH_MUXCTRL_SDIO_MICROSD);
+        case MANGOH_MUXCTRL_OP_SDIO_SEL_IOT0:
+            return routing_AddSdio(transitionPtr, MANGOH_MUXCTRL_SDIO_IOT0);
+
+        case MANGOH_MUXCTRL_OP_AUDIO_DISABLE:
+            return routing_AddAudio(transitionPtr, MANGOH_MUXCTRL_AUDIO_DISABLED);
+        case MANGOH_MUXCTRL_OP_AUDIO_SELECT_IOT0_CODEC:
+            return routing_AddAudio(transitionPtr, MANGOH_MUXCTRL_AUDIO_IOT0_CODEC);
+        case MANGOH_MUXCTRL_OP_AUDIO_SELECT_ONBOARD_CODEC:
+            return routing_AddAudio(transitionPtr, MANGOH_MUXCTRL_AUDIO_ONBOARD_CODEC);
+        case MANGOH_MUXCTRL_OP_AUDIO_SELECT_INTERNAL_CODEC:
+            return routing_AddAudio(transitionPtr, MANGOH_MUXCTRL_AUDIO_INTERNAL_CODEC);
+
+        case MANGOH_MUXCTRL_OP_IOT_SLOT0_DEASSERT_RESET:
+            return routing_AddReset(transitionPtr, MANGOH_MUXCTRL_RESET_IOT0, false);
+        case MANGOH_MUXCTRL_OP_IOT_SLOT1_DEASSERT_RESET:
+            return routing_AddReset(transitionPtr, MANGOH_MUXCTRL_RESET_IOT1, false);
+        case MANGOH_MUXCTRL_OP_IOT_SLOT2_DEASSERT_RESET:
+            return routing_AddReset(transitionPtr, MANGOH_MUXCTRL_RESET_IOT2, false);
+        case MANGOH_MUXCTRL_OP_ARDUINO_ASSERT_RESET:
+            return routing_AddReset(transitionPtr, MANGOH_MUXCTRL_RESET_ARDUINO, true);
+        case MANGOH_MUXCTRL_OP_ARDUINO_DEASSERT_RESET:
+            return routing_AddReset(transitionPtr, MANGOH_MUXCTRL_RESET_ARDUINO, false);
+
+        default:
+            LE_ERROR("Invalid operation (%d)", op);
+            return LE_BAD_PARAMETER;
+    }
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Enable UART 1 on IoT slot 1
+ * Get the mux an operation sets.
  *
  * @return
- *      - LE_FAULT
- *      - LE_OK
+ *      true if the operation sets a mux, false if it works a reset line
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t mangoh_muxCtrl_Iot1Uart1On
+static bool GetOperationGroup
 (
-    void
+    mangoh_muxCtrl_Operation_t op,
+    mangoh_muxCtrl_MuxGroup_t* groupPtr  ///< [OUT] Mux set by the operation
 )
 {
-    if (mangoh_gpioPinUart1Select_Deactivate() != LE_OK)
+    switch (op)
     {
-        LE_ERROR("Failed to select IoT slot 1 for UART 1");
-        return LE_FAULT;
-    }
+        case MANGOH_MUXCTRL_OP_IOT_ALL_UART1_OFF:
+        case MANGOH_MUXCTRL_OP_IOT0_UART1_ON:
+        case MANGOH_MUXCTRL_OP_IOT1_UART1_ON:
+            *groupPtr = MANGOH_MUXCTRL_MUX_UART1;
+            return true;
 
-    if (mangoh_gpioPinUart1Enable_Activate() != LE_OK)
-    {
-        LE_ERROR("Failed to enable UART 1");
-        return LE_FAULT;
-    }
+        case MANGOH_MUXCTRL_OP_IOT_ALL_SPI_OFF:
+        case MANGOH_MUXCTRL_OP_IOT0_SPI1_ON:
+        case MANGOH_MUXCTRL_OP_IOT1_SPI1_ON:
+            *groupPtr = MANGOH_MUXCTRL_MUX_SPI;
+            return true;
 
-    return LE_OK;
+        case MANGOH_MUXCTRL_OP_IOT_ALL_UART2_OFF:
+        case MANGOH_MUXCTRL_OP_IOT2_UART2_ON:
+        case MANGOH_MUXCTRL_OP_UART2_DEBUG_ON:
+            *groupPtr = MANGOH_MUXCTRL_MUX_UART2;
+            return true;
+
+        case MANGOH_MUXCTRL_OP_SDIO_SEL_MICRO_SD:
+        case MANGOH_MUXCTRL_OP_SDIO_SEL_IOT0:
+            *groupPtr = MANGOH_MUXCTRL_MUX_SDIO;
+            return true;
+
+        case MANGOH_MUXCTRL_OP_AUDIO_DISABLE:
+        case MANGOH_MUXCTRL_OP_AUDIO_SELECT_IOT0_CODEC:
+        case MANGOH_MUXCTRL_OP_AUDIO_SELECT_ONBOARD_CODEC:
+        case MANGOH_MUXCTRL_OP_AUDIO_SELECT_INTERNAL_CODEC:
+            *groupPtr = MANGOH_MUXCTRL_MUX_AUDIO;
+            return true;
+
+        default:
+            return false;
+    }
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Disable SPI
+ * Get the mux a request sets.  Only single mux operations count; operations in the same group set
+ * the same mux to different positions, so only the last of a run of them has a lasting effect.
  *
  * @return
- *      - LE_FAULT
- *      - LE_OK
+ *      true if the request is a single mux operation
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t mangoh_muxCtrl_IotAllSpiOff
+static bool GetMuxGroup
 (
-    void
+    const Request_t* requestPtr,
+    mangoh_muxCtrl_MuxGroup_t* groupPtr  ///< [OUT] Mux set by the request
 )
 {
-    if (mangoh_gpioPinSpiEnable_Deactivate() != LE_OK)
-    {
-        LE_ERROR("Failed to disable SPI");
-        return LE_FAULT;
-    }
-
-    return LE_OK;
+    return (requestPtr->type == REQUEST_OPERATION) &&
+           GetOperationGroup(requestPtr->params.op, groupPtr);
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Enable SPI on IoT slot 0
+ * Get the reset line an operation works.
  *
  * @return
- *      - LE_FAULT
- *      - LE_OK
+ *      true if the operation works a reset line
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t mangoh_muxCtrl_Iot0Spi1On
+static bool GetOperationResetTarget
 (
-    void
+    mangoh_muxCtrl_Operation_t op,
+    mangoh_muxCtrl_ResetTarget_t* targetPtr  ///< [OUT] Target of the reset line
 )
 {
-    if (mangoh_gpioPinSpiSelect_Activate() != LE_OK)
+    switch (op)
     {
-        LE_ERROR("Failed to select IoT slot 0 for SPI");
-        return LE_FAULT;
-    }
+        case MANGOH_MUXCTRL_OP_IOT_SLOT0_DEASSERT_RESET:
+            *targetPtr = MANGOH_MUXCTRL_RESET_IOT0;
+            return true;
 
-    if (mangoh_gpioPinSpiEnable_Activate() != LE_OK)
-    {
-        LE_ERROR("Failed to enable SPI");
-        return LE_FAULT;
-    }
+        case MANGOH_MUXCTRL_OP_IOT_SLOT1_DEASSERT_RESET:
+            *targetPtr = MANGOH_MUXCTRL_RESET_IOT1;
+            return true;
 
-    return LE_OK;
+        case MANGOH_MUXCTRL_OP_IOT_SLOT2_DEASSERT_RESET:
+            *targetPtr = MANGOH_MUXCTRL_RESET_IOT2;
+            return true;
+
+        case MANGOH_MUXCTRL_OP_ARDUINO_ASSERT_RESET:
+        case MANGOH_MUXCTRL_OP_ARDUINO_DEASSERT_RESET:
+        case MANGOH_MUXCTRL_OP_ARDUINO_RESET:
+            *targetPtr = MANGOH_MUXCTRL_RESET_ARDUINO;
+            return true;
+
+        default:
+            return false;
+    }
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Mux Control: mangOH IOT1 SPI1 ON.
+ * Find a reset line that a request would move while a pulse on it is in progress.  The end of the
+ * pulse would undo the request, so the request has to wait for it.  A pulse of the same target
+ * doesn't wait; it ends along with the pulse in progress.
  *
  * @return
- *      - LE_FAULT
- *      - LE_OK
+ *      true if the request has to wait for the pulse of *targetPtr to end
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t mangoh_muxCtrl_Iot1Spi1On
+static bool GetPulseToWaitFor
 (
-    void
+    const Request_t* requestPtr,
+    mangoh_muxCtrl_ResetTarget_t* targetPtr  ///< [OUT] Target whose pulse to wait for
 )
 {
-    if (mangoh_gpioPinSpiSelect_Deactivate() != LE_OK)
+    switch (requestPtr->type)
     {
-        LE_ERROR("Failed to select IoT slot 1 for SPI");
-        return LE_FAULT;
-    }
+        case REQUEST_OPERATION:
+            return (requestPtr->params.op != MANGOH_MUXCTRL_OP_ARDUINO_RESET) &&
+                   GetOperationResetTarget(requestPtr->params.op, targetPtr) &&
+                   resetPulse_IsInProgress(*targetPtr);
 
-    if (mangoh_gpioPinSpiEnable_Activate() != LE_OK)
-    {
-        LE_ERROR("Failed to enable SPI");
-        return LE_FAULT;
-    }
+        case REQUEST_SEQUENCE:
+            for (size_t i = 0; i < requestPtr->params.sequence.numOps; i++)
+            {
+                if (GetOperationResetTarget(requestPtr->params.sequence.ops[i], targetPtr) &&
+                    resetPulse_IsInProgress(*targetPtr))
+                {
+                    return true;
+                }
+            }
+            return false;
 
-    return LE_OK;
+        default:
+            return false;
+    }
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Disable UART 2
+ * Check that no other client holds the lease on a mux a request would change.  A sequence is
+ * checked as a whole, so it is refused before any of it has run.
  *
  * @return
- *      - LE_FAULT
- *      - LE_OK
+ *      true if the request may run
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t mangoh_muxCtrl_IotAllUart2Off
+static bool IsPermitted
 (
-    void
+    const Request_t* requestPtr
 )
 {
-    if (mangoh_gpioPinUart2Enable_Deactivate() != LE_OK)
+    mangoh_muxCtrl_MuxGroup_t group;
+
+    switch (requestPtr->type)
     {
-        LE_ERROR("Failed to disable UART 2");
-        return LE_FAULT;
+        case REQUEST_OPERATION:
+            return !GetOperationGroup(requestPtr->params.op, &group) ||
+                   lease_IsAllowed(group, requestPtr->sessionRef);
+
+        case REQUEST_PULSE:
+            return true;
+
+        case REQUEST_CONFIGURATION:
+            for (group = MANGOH_MUXCTRL_MUX_UART1; group <= MANGOH_MUXCTRL_MUX_AUDIO; group++)
+            {
+                if (!lease_IsAllowed(group, requestPtr->sessionRef))
+                {
+                    return false;
+                }
+            }
+            return true;
+
+        case REQUEST_SEQUENCE:
+            for (size_t i = 0; i < requestPtr->params.sequence.numOps; i++)
+            {
+                if (GetOperationGroup(requestPtr->params.sequence.ops[i], &group) &&
+                    !lease_IsAllowed(group, requestPtr->sessionRef))
+                {
+                    return false;
+                }
+            }
+            return true;
     }
 
-    return LE_OK;
+    return true;
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Enable UART 2 on IoT slot 2
- *
- * @return
- *      - LE_FAULT
- *      - LE_OK
+ * Called on the main thread when the transition of an operation has been committed.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t mangoh_muxCtrl_Iot2Uart2On
+static void OperationCommitted
 (
-    void
+    le_result_t result,
+    void* contextPtr  ///< Request_t
 )
 {
-    if (mangoh_gpioPinUart2Select_Activate() != LE_OK)
-    {
-        LE_ERROR("Failed to select IoT slot 2 for UART 2");
-        return LE_FAULT;
-    }
+    Request_t* requestPtr = contextPtr;
 
-    if (mangoh_gpioPinUart2Enable_Activate() != LE_OK)
+    if (result != LE_OK)
     {
-        LE_ERROR("Failed to enable UART 2");
-        return LE_FAULT;
+        LE_ERROR("Failed to %s", OperationDescriptions[requestPtr->runningOp]);
+        result = LE_FAULT;
     }
 
-    return LE_OK;
+    requestPtr->opDoneFunc(result, requestPtr);
 }
 
+// Forward declaration, as a reset pulse lets the queue move on through PulseAsserted().
+static void PulseAsserted(le_result_t result, void* contextPtr);
+
 //--------------------------------------------------------------------------------------------------
 /**
- * Enable UART 2 on the debug port
- *
- * @return
- *      - LE_FAULT
- *      - LE_OK
+ * Start an operation of a request.  doneFunc is called with the request as its context when the
+ * operation completes, which may be before this function returns.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t mangoh_muxCtrl_Uart2DebugOn
+static void StartOperation
 (
-    void
+    Request_t* requestPtr,          ///< Request the operation is part of
+    mangoh_muxCtrl_Operation_t op,  ///< Operation
+    DoneFunc_t doneFunc             ///< Function to call when the operation is complete
 )
 {
-    if (mangoh_gpioPinUart2Select_Deactivate() != LE_OK)
+    if (op == MANGOH_MUXCTRL_OP_ARDUINO_RESET)
     {
-        LE_ERROR("Failed to select the debug port for UART 2");
-        return LE_FAULT;
+        // A sequence keeps the queue until the pulse is over, as its later operations have to
+        // run after it.
+        resetPulse_Start(MANGOH_MUXCTRL_RESET_ARDUINO, requestPtr->clientPid, op,
+                         (requestPtr->type == REQUEST_SEQUENCE) ? NULL : PulseAsserted,
+                         doneFunc, requestPtr);
+        return;
     }
 
-    if (mangoh_gpioPinUart2Enable_Activate() != LE_OK)
+    pinState_Transition_t transition;
+
+    pinState_StartTransition(&transition, false);
+    transition.traceClient = requestPtr->clientPid;
+    transition.traceCall = op;
+
+    le_result_t result = AddOperation(&transition, op);
+    if (result != LE_OK)
     {
-        LE_ERROR("Failed to enable UART 2");
-        return LE_FAULT;
+        doneFunc(result, requestPtr);
+        return;
     }
 
-    return LE_OK;
+    requestPtr->runningOp = op;
+    requestPtr->opDoneFunc = doneFunc;
+    worker_Commit(&transition, OperationCommitted, requestPtr);
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Connect the SDIO interface to the MicroSD card slot
- *
- * @return
- *      - LE_FAULT
- *      - LE_OK
+ * Get the number of microseconds since a time given by le_clk_GetRelativeTime().
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t mangoh_muxCtrl_SdioSelMicroSd
+static uint32_t ElapsedUs
 (
-    void
+    le_clk_Time_t since
 )
 {
-    if (mangoh_gpioPinSdioSelect_Activate() != LE_OK)
-    {
-        LE_ERROR("Failed to select MicroSD slot for SDIO");
-        return LE_FAULT;
-    }
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), since);
 
-    return LE_OK;
+    return (uint32_t)(elapsed.sec * 1000000 + elapsed.usec);
 }
 
+// Forward declaration, as a configuration request completes from ConfigurationCommitted().
+static void CompleteRequest(Request_t* requestPtr, le_result_t result);
+
 //--------------------------------------------------------------------------------------------------
 /**
- * Connect the SDIO interface to IoT slot 0
- *
- * @return
- *      - LE_FAULT
- *      - LE_OK
+ * Called on the main thread when the transition of a REQUEST_CONFIGURATION request has been
+ * committed.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t mangoh_muxCtrl_SdioSelIot0
+static void ConfigurationCommitted
 (
-    void
+    le_result_t result,
+    void* contextPtr  ///< Request_t
 )
 {
-    if (mangoh_gpioPinSdioSelect_Deactivate() != LE_OK)
+    if (result != LE_OK)
     {
-        LE_ERROR("Failed to select IoT slot 0 for SDIO");
-        return LE_FAULT;
+        LE_ERROR("Failed to apply mux configuration");
+        result = LE_FAULT;
     }
 
-    return LE_OK;
+    CompleteRequest(contextPtr, result);
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Disable the audio path
- *
- * @return
- *      LE_OK on success or LE_FAULT on failure
+ * Apply the complete routing of a REQUEST_CONFIGURATION request as a single transition.  If one
+ * of the routes is not valid, nothing is changed and the request completes with LE_BAD_PARAMETER.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t mangoh_muxCtrl_AudioDisable
+static void ApplyConfiguration
 (
-    void
+    Request_t* requestPtr
 )
 {
-    if (mangoh_gpioPinPcmEnable_Deactivate() != LE_OK)
-    {
-        LE_ERROR("Failed to disable PCM");
-        return LE_FAULT;
-    }
+    pinState_Transition_t transition;
 
-    if (mangoh_gpioPinPcmAnalogSelect_Deactivate() != LE_OK)
+    pinState_StartTransition(&transition, false);
+    transition.traceClient = requestPtr->clientPid;
+    transition.traceCall = STATS_CALL_APPLY_CONFIGURATION;
+    if ((routing_AddUart1(&transition, requestPtr->params.config.uart1) != LE_OK) ||
+        (routing_AddSpi(&transition, requestPtr->params.config.spi) != LE_OK) ||
+        (routing_AddUart2(&transition, requestPtr->params.config.uart2) != LE_OK) ||
+        (routing_AddSdio(&transition, requestPtr->params.config.sdio) != LE_OK) ||
+        (routing_AddAudio(&transition, requestPtr->params.config.audio) != LE_OK))
     {
-        LE_ERROR("Failed to select off-chip codec location");
-        return LE_FAULT;
+        CompleteRequest(requestPtr, LE_BAD_PARAMETER);
+        return;
     }
 
-    return LE_OK;
+    worker_Commit(&transition, ConfigurationCommitted, requestPtr);
 }
 
+// Forward declaration, as completing a request starts the next one.
+static void ProcessQueue(void);
+
 //--------------------------------------------------------------------------------------------------
 /**
- * Route audio via a codec installed in IoT slot 0
- *
- * @return
- *      LE_OK on success or LE_FAULT on failure
+ * Deliver the result of a request to its client and free the request.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t mangoh_muxCtrl_AudioSelectIot0Codec
+static void DeliverResult
 (
-    void
+    Request_t* requestPtr,
+    le_result_t result
 )
 {
-    if (mangoh_gpioPinPcmSelect_Deactivate() != LE_OK)
+    switch (requestPtr->type)
     {
-        LE_ERROR("Failed to select IoT slot 0 for PCM");
-        return LE_FAULT;
+        case REQUEST_OPERATION:
+            stats_RecordCall(requestPtr->params.op, result);
+            break;
+        case REQUEST_PULSE:
+            stats_RecordCall(STATS_CALL_PULSE_RESET, result);
+            break;
+        case REQUEST_CONFIGURATION:
+            stats_RecordCall(STATS_CALL_APPLY_CONFIGURATION, result);
+            break;
+        case REQUEST_SEQUENCE:
+            stats_RecordCall(STATS_CALL_EXECUTE_SEQUENCE, result);
+            break;
     }
 
-    if (mangoh_gpioPinPcmAnalogSelect_Deactivate() != LE_OK)
+    if (requestPtr->cmdRef != NULL)
     {
-        LE_ERROR("Failed to select off-chip codec location");
-        return LE_FAULT;
+        if (requestPtr->type == REQUEST_SEQUENCE)
+        {
+            mangoh_muxCtrl_ExecuteSequenceRespond(
+                requestPtr->cmdRef,
+                result,
+                (result == LE_OK) ? -1 : (int32_t)requestPtr->params.sequence.current);
+        }
+        else
+        {
+            requestPtr->respondFunc(requestPtr->cmdRef, result);
+        }
     }
-
-    if (mangoh_gpioPinPcmEnable_Activate() != LE_OK)
+    else if ((requestPtr->handlerPtr != NULL) && (requestPtr->sessionRef != NULL))
     {
-        LE_ERROR("Failed to enable PCM");
-        return LE_FAULT;
+        requestPtr->handlerPtr(result, requestPtr->contextPtr);
     }
 
-    return LE_OK;
+    le_mem_Release(requestPtr);
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Route audio via the codec on the mangOH board
- *
- * @return
- *      LE_OK on success or LE_FAULT on failure
+ * Count the active request as complete in the queue statistics.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t mangoh_muxCtrl_AudioSelectOnboardCodec
+static void RecordServiceTime
 (
-    void
+    const Request_t* requestPtr
 )
 {
-    if (mangoh_gpioPinPcmSelect_Activate() != LE_OK)
+    uint32_t serviceUs = ElapsedUs(requestPtr->startTime);
+    QueueStats.completed++;
+    QueueStats.totalServiceUs += serviceUs;
+    if (serviceUs > QueueStats.maxServiceUs)
     {
-        LE_ERROR("Failed to select onboard for PCM");
-        return LE_FAULT;
+        QueueStats.maxServiceUs = serviceUs;
     }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Deliver the result of a request, and of the requests it superseded, to their clients and free
+ * them.  If it was the active request, start the next request.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CompleteRequest
+(
+    Request_t* requestPtr,
+    le_result_t result
+)
+{
+    bool wasActive = (requestPtr == ActiveRequestPtr);
 
-    if (mangoh_gpioPinPcmAnalogSelect_Deactivate() != LE_OK)
+    if (wasActive)
+    {
+        RecordServiceTime(requestPtr);
+    }
+    else
     {
-        LE_ERROR("Failed to select off-chip codec location");
-        return LE_FAULT;
+        // A pulse request that let the queue move on when its target went into reset.
+        le_sls_Link_t* prevLinkPtr = NULL;
+        le_sls_Link_t* linkPtr = le_sls_Peek(&PulseRequests);
+        while (linkPtr != &requestPtr->link)
+        {
+            LE_ASSERT(linkPtr != NULL);
+            prevLinkPtr = linkPtr;
+            linkPtr = le_sls_PeekNext(&PulseRequests, linkPtr);
+        }
+        le_sls_RemoveAfter(&PulseRequests, prevLinkPtr);
     }
 
-    if (mangoh_gpioPinPcmEnable_Activate() != LE_OK)
+    // A superseded request gets the result of the transition that replaced it, as that is what
+    // decided the final position of its mux.
+    le_sls_Link_t* linkPtr;
+    while ((linkPtr = le_sls_Pop(&requestPtr->coalesced)) != NULL)
     {
-        LE_ERROR("Failed to enable PCM");
-        return LE_FAULT;
+        DeliverResult(CONTAINER_OF(linkPtr, Request_t, link), result);
     }
 
-    return LE_OK;
+    DeliverResult(requestPtr, result);
+
+    if (wasActive)
+    {
+        ActiveRequestPtr = NULL;
+        ProcessQueue();
+    }
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Route audio via a codec internal to the CF3 module
- *
- * @return
- *      LE_OK on success or LE_FAULT on failure
+ * Let the queue move on once a pulse request has put its target in reset.  The rest of the pulse
+ * is a timer and the write that takes the target out of reset, which later requests don't have to
+ * wait for; those that would move the same reset line wait for the pulse to end instead.  The
+ * request is answered when the pulse ends.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t mangoh_muxCtrl_AudioSelectInternalCodec
+static void PulseAsserted
 (
-    void
+    le_result_t result,
+    void* contextPtr  ///< Request_t
 )
 {
-    if (mangoh_gpioPinPcmEnable_Deactivate() != LE_OK)
-    {
-        LE_ERROR("Failed to disable PCM");
-        return LE_FAULT;
-    }
+    Request_t* requestPtr = contextPtr;
 
-    if (mangoh_gpioPinPcmAnalogSelect_Activate() != LE_OK)
-    {
-        LE_ERROR("Failed to select on-chip codec location");
-        return LE_FAULT;
-    }
+    LE_ASSERT(requestPtr == ActiveRequestPtr);
 
-    return LE_OK;
+    RecordServiceTime(requestPtr);
+    le_sls_Queue(&PulseRequests, &requestPtr->link);
+    ActiveRequestPtr = NULL;
+
+    ProcessQueue();
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Take IoT slot 0 card out of reset
- *
- * @return
- *      - LE_FAULT
- *      - LE_OK
+ * Complete a request once its operation is done.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t mangoh_muxCtrl_IotSlot0DeassertReset
+static void RequestDone
 (
-    void
+    le_result_t result,
+    void* contextPtr  ///< Request_t
 )
 {
-    if (mangoh_gpioPinIot0Reset_Deactivate() != LE_OK)
-    {
-        LE_ERROR("Failed to take IoT slot 0 out of reset");
-        return LE_FAULT;
-    }
-
-    return LE_OK;
+    CompleteRequest(contextPtr, result);
 }
 
+// Forward declaration, as sequence operations complete through SequenceOpDone().
+static void SequenceOpDone(le_result_t result, void* contextPtr);
+
 //--------------------------------------------------------------------------------------------------
 /**
- * Take IoT slot 1 card out of reset
- *
- * @return
- *      - LE_FAULT
- *      - LE_OK
+ * Start the next operation of a sequence, or complete the request if there are none left.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t mangoh_muxCtrl_IotSlot1DeassertReset
+static void RunSequence
 (
-    void
+    Request_t* requestPtr
 )
 {
-    if (mangoh_gpioPinIot1Reset_Deactivate() != LE_OK)
+    if (requestPtr->params.sequence.current < requestPtr->params.sequence.numOps)
     {
-        LE_ERROR("Failed to take IoT slot 1 out of reset");
-        return LE_FAULT;
+        StartOperation(requestPtr,
+                       requestPtr->params.sequence.ops[requestPtr->params.sequence.current],
+                       SequenceOpDone);
+    }
+    else
+    {
+        CompleteRequest(requestPtr, LE_OK);
     }
-
-    return LE_OK;
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Take IoT slot 2 card out of reset
- *
- * @return
- *      - LE_FAULT
- *      - LE_OK
+ * Move on to the next operation of a sequence, or stop the sequence if the operation failed.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t mangoh_muxCtrl_IotSlot2DeassertReset
+static void SequenceOpDone
 (
-    void
+    le_result_t result,
+    void* contextPtr  ///< Request_t
 )
 {
-    if (mangoh_gpioPinIot2Reset_Deactivate() != LE_OK)
+    Request_t* requestPtr = contextPtr;
+
+    if (result != LE_OK)
     {
-        LE_ERROR("Failed to take IoT slot 2 out of reset");
-        return LE_FAULT;
+        CompleteRequest(requestPtr, result);
+        return;
     }
 
-    return LE_OK;
+    requestPtr->params.sequence.current++;
+    RunSequence(requestPtr);
 }
 
+// Forward declaration, as a request waiting for a reset pulse starts from PulseEnded().
+static void StartRequest(Request_t* requestPtr);
+
 //--------------------------------------------------------------------------------------------------
 /**
- * Put Arduino in reset state
+ * Start the active request once the reset pulse it was waiting for has ended.
+ */
+//--------------------------------------------------------------------------------------------------
+static void PulseEnded
+(
+    le_result_t result,
+    void* contextPtr  ///< Request_t
+)
+{
+    LE_ASSERT(contextPtr == ActiveRequestPtr);
+
+    StartRequest(contextPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start running a request.
+ */
+//--------------------------------------------------------------------------------------------------
+static void StartRequest
+(
+    Request_t* requestPtr
+)
+{
+    mangoh_muxCtrl_ResetTarget_t target;
+    if (GetPulseToWaitFor(requestPtr, &target))
+    {
+        resetPulse_WaitForEnd(target, PulseEnded, requestPtr);
+        return;
+    }
+
+    uint32_t waitUs = ElapsedUs(requestPtr->queuedTime);
+    QueueStats.totalWaitUs += waitUs;
+    if (waitUs > QueueStats.maxWaitUs)
+    {
+        QueueStats.maxWaitUs = waitUs;
+    }
+    requestPtr->startTime = le_clk_GetRelativeTime();
+
+    // Leases are checked when the request starts rather than when it is queued, as that is when
+    // it would move the mux.
+    if (!IsPermitted(requestPtr))
+    {
+        LE_WARN("Refusing a request that would change a mux leased by another client");
+        CompleteRequest(requestPtr, LE_NOT_PERMITTED);
+        return;
+    }
+
+    switch (requestPtr->type)
+    {
+        case REQUEST_OPERATION:
+            StartOperation(requestPtr, requestPtr->params.op, RequestDone);
+            break;
+
+        case REQUEST_PULSE:
+            resetPulse_Start(requestPtr->params.target, requestPtr->clientPid,
+                             STATS_CALL_PULSE_RESET, PulseAsserted, RequestDone, requestPtr);
+            break;
+
+        case REQUEST_CONFIGURATION:
+            ApplyConfiguration(requestPtr);
+            break;
+
+        case REQUEST_SEQUENCE:
+            RunSequence(requestPtr);
+            break;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Hand a request over to a later queued request for the same mux group, if there is one and
+ * nothing queued in between depends on the order of the two.  Only other single mux operations
+ * may be in between; anything else (a reset, a configuration or a sequence) stops the search.
  *
  * @return
- *      - LE_FAULT
- *      - LE_UNSUPPORTED if the board doesn't have an Arduino
- *      - LE_OK
+ *      true if the request was superseded; it then completes along with the request that
+ *      superseded it.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t mangoh_muxCtrl_ArduinoAssertReset
+static bool Coalesce
 (
+    Request_t* requestPtr
 )
 {
-    if (mangoh_gpioPinArduinoReset_Activate() != LE_OK)
+    mangoh_muxCtrl_MuxGroup_t group;
+    if (!GetMuxGroup(requestPtr, &group))
     {
-        LE_ERROR("Failed to put Arduino reset pin low");
-        return LE_FAULT;
+        return false;
     }
 
-    return LE_OK;
+    // Requests for a leased mux may be from different clients with different results (the
+    // holder's runs, the others' are refused), so none of them can stand in for another.
+    if (lease_IsHeld(group))
+    {
+        return false;
+    }
+
+    for (le_sls_Link_t* linkPtr = le_sls_Peek(&RequestQueue);
+         linkPtr != NULL;
+         linkPtr = le_sls_PeekNext(&RequestQueue, linkPtr))
+    {
+        Request_t* laterPtr = CONTAINER_OF(linkPtr, Request_t, link);
+        mangoh_muxCtrl_MuxGroup_t laterGroup;
+
+        if (!GetMuxGroup(laterPtr, &laterGroup))
+        {
+            return false;
+        }
+
+        if (laterGroup == group)
+        {
+            le_sls_Link_t* supersededLinkPtr;
+            while ((supersededLinkPtr = le_sls_Pop(&requestPtr->coalesced)) != NULL)
+            {
+                le_sls_Queue(&laterPtr->coalesced, supersededLinkPtr);
+            }
+            le_sls_Queue(&laterPtr->coalesced, &requestPtr->link);
+
+            CoalescedCount++;
+            LE_DEBUG("Skipping '%s', superseded by '%s'",
+                     OperationDescriptions[requestPtr->params.op],
+                     OperationDescriptions[laterPtr->params.op]);
+            return true;
+        }
+    }
+
+    return false;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the active request once its coalescing window has ended, unless it has been superseded.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CoalescingTimerExpired
+(
+    le_timer_Ref_t timer
+)
+{
+    if (Coalesce(ActiveRequestPtr))
+    {
+        ActiveRequestPtr = NULL;
+        ProcessQueue();
+    }
+    else
+    {
+        StartRequest(ActiveRequestPtr);
+    }
+}
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Put Arduino out of reset state
+ * Run queued requests until the queue is empty or a request has to wait for something (such as a
+ * reset pulse or the end of its coalescing window) to complete.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ProcessQueue
+(
+    void
+)
+{
+    if (ProcessingQueue)
+    {
+        return;
+    }
+
+    ProcessingQueue = true;
+
+    while (ActiveRequestPtr == NULL)
+    {
+        le_sls_Link_t* linkPtr = le_sls_Pop(&RequestQueue);
+        if (linkPtr == NULL)
+        {
+            break;
+        }
+
+        ActiveRequestPtr = CONTAINER_OF(linkPtr, Request_t, link);
+        QueueStats.depth--;
+
+        if ((ActiveRequestPtr->sessionRef == NULL) && (ActiveRequestPtr->cmdRef == NULL) &&
+            le_sls_IsEmpty(&ActiveRequestPtr->coalesced))
+        {
+            // Nobody is left to tell about the result.
+            le_mem_Release(ActiveRequestPtr);
+            ActiveRequestPtr = NULL;
+            continue;
+        }
+
+        mangoh_muxCtrl_MuxGroup_t group;
+        if ((CoalescingWindowUs > 0) && GetMuxGroup(ActiveRequestPtr, &group))
+        {
+            uint32_t waitedUs = ElapsedUs(ActiveRequestPtr->queuedTime);
+            if (waitedUs < CoalescingWindowUs)
+            {
+                uint32_t remainingUs = CoalescingWindowUs - waitedUs;
+                le_clk_Time_t interval =
+                {
+                    .sec = remainingUs / 1000000,
+                    .usec = remainingUs % 1000000
+                };
+                le_timer_SetInterval(CoalescingTimer, interval);
+                le_timer_Start(CoalescingTimer);
+                break;
+            }
+
+            if (Coalesce(ActiveRequestPtr))
+            {
+                ActiveRequestPtr = NULL;
+                continue;
+            }
+        }
+
+        StartRequest(ActiveRequestPtr);
+    }
+
+    ProcessingQueue = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Allocate a request from a client session.
+ */
+//--------------------------------------------------------------------------------------------------
+static Request_t* NewRequestForSession
+(
+    RequestType_t type,
+    le_msg_SessionRef_t sessionRef
+)
+{
+    Request_t* requestPtr = le_mem_ForceAlloc(RequestPool);
+
+    memset(requestPtr, 0, sizeof(*requestPtr));
+    requestPtr->link = LE_SLS_LINK_INIT;
+    requestPtr->coalesced = LE_SLS_LIST_INIT;
+    requestPtr->type = type;
+    requestPtr->sessionRef = sessionRef;
+    if (le_msg_GetClientProcessId(requestPtr->sessionRef, &requestPtr->clientPid) != LE_OK)
+    {
+        requestPtr->clientPid = 0;
+    }
+
+    return requestPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Allocate a request from the client of the message being handled.
+ */
+//--------------------------------------------------------------------------------------------------
+static Request_t* NewRequest
+(
+    RequestType_t type
+)
+{
+    return NewRequestForSession(type, mangoh_muxCtrl_GetClientSessionRef());
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a request to the queue and run it if nothing else is running.
  *
  * @return
- *      - LE_FAULT
- *      - LE_UNSUPPORTED if the board doesn't have an Arduino
  *      - LE_OK
+ *      - LE_BUSY if the queue is full; the request is not queued
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t mangoh_muxCtrl_ArduinoDeassertReset
+static le_result_t Enqueue
 (
+    Request_t* requestPtr
 )
 {
-    if (mangoh_gpioPinArduinoReset_Deactivate() != LE_OK)
+    if (QueueStats.depth >= REQUEST_QUEUE_SIZE)
+    {
+        LE_WARN("Request queue is full");
+        QueueStats.rejected++;
+        return LE_BUSY;
+    }
+
+    requestPtr->queuedTime = le_clk_GetRelativeTime();
+    le_sls_Queue(&RequestQueue, &requestPtr->link);
+    QueueStats.depth++;
+    if (QueueStats.depth > QueueStats.maxDepth)
     {
-        LE_ERROR("Failed to put Arduino reset pin high");
-        return LE_FAULT;
+        QueueStats.maxDepth = QueueStats.depth;
     }
 
+    ProcessQueue();
+
     return LE_OK;
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Perform Arduino reset
+ * Queue a synchronous request.  The client gets its response once the request is complete, or
+ * straight away with LE_BUSY if the queue is full.
+ */
+//--------------------------------------------------------------------------------------------------
+static void QueueRequest
+(
+    Request_t* requestPtr,
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef,  ///< Command to respond to
+    RespondFunc_t respondFunc              ///< Function used to respond (unused for sequences)
+)
+{
+    requestPtr->cmdRef = cmdRef;
+    requestPtr->respondFunc = respondFunc;
+
+    if (Enqueue(requestPtr) != LE_OK)
+    {
+        if (requestPtr->type == REQUEST_SEQUENCE)
+        {
+            mangoh_muxCtrl_ExecuteSequenceRespond(cmdRef, LE_BUSY, -1);
+        }
+        else
+        {
+            respondFunc(cmdRef, LE_BUSY);
+        }
+        le_mem_Release(requestPtr);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queue an asynchronous request.  The completion handler is called once the request is complete,
+ * or straight away with LE_BUSY if the queue is full.
+ */
+//--------------------------------------------------------------------------------------------------
+static void QueueAsyncRequest
+(
+    Request_t* requestPtr,
+    mangoh_muxCtrl_CompletionHandlerFunc_t handlerPtr,  ///< Completion handler
+    void* contextPtr                                    ///< Context of the handler
+)
+{
+    requestPtr->handlerPtr = handlerPtr;
+    requestPtr->contextPtr = contextPtr;
+
+    if (Enqueue(requestPtr) != LE_OK)
+    {
+        handlerPtr(LE_BUSY, contextPtr);
+        le_mem_Release(requestPtr);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queue a synchronous request to run one operation.
+ */
+//--------------------------------------------------------------------------------------------------
+static void QueueOperation
+(
+    mangoh_muxCtrl_Operation_t op,         ///< Operation
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef,  ///< Command to respond to
+    RespondFunc_t respondFunc              ///< Function used to respond
+)
+{
+    Request_t* requestPtr = NewRequest(REQUEST_OPERATION);
+
+    requestPtr->params.op = op;
+    QueueRequest(requestPtr, cmdRef, respondFunc);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queue the switch of a bus at a slot boundary of a schedule, as an asynchronous request from the
+ * session that started the schedule.
+ */
+//--------------------------------------------------------------------------------------------------
+static void QueueScheduledSwitch
+(
+    mangoh_muxCtrl_Operation_t op,                      ///< Operation that switches the bus
+    le_msg_SessionRef_t sessionRef,                     ///< Session that started the schedule
+    mangoh_muxCtrl_CompletionHandlerFunc_t doneFunc,    ///< Called when the switch is complete
+    void* contextPtr                                    ///< Passed to doneFunc
+)
+{
+    Request_t* requestPtr = NewRequestForSession(REQUEST_OPERATION, sessionRef);
+
+    requestPtr->params.op = op;
+    QueueAsyncRequest(requestPtr, doneFunc, contextPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Forget the client of a request, and of the requests it superseded, if it is from a session that
+ * has closed.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ForgetSession
+(
+    Request_t* requestPtr,
+    le_msg_SessionRef_t sessionRef
+)
+{
+    if (requestPtr->sessionRef == sessionRef)
+    {
+        requestPtr->sessionRef = NULL;
+    }
+
+    for (le_sls_Link_t* linkPtr = le_sls_Peek(&requestPtr->coalesced);
+         linkPtr != NULL;
+         linkPtr = le_sls_PeekNext(&requestPtr->coalesced, linkPtr))
+    {
+        Request_t* supersededPtr = CONTAINER_OF(linkPtr, Request_t, link);
+        if (supersededPtr->sessionRef == sessionRef)
+        {
+            supersededPtr->sessionRef = NULL;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Forget the client of any request from a session that has closed, so its completion handler is
+ * not called.  Asynchronous requests from that session that have not started yet are dropped.
+ * Its schedules are stopped and the leases it held are given up.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SessionClosed
+(
+    le_msg_SessionRef_t sessionRef,
+    void* contextPtr
+)
+{
+    if (ActiveRequestPtr != NULL)
+    {
+        ForgetSession(ActiveRequestPtr, sessionRef);
+    }
+
+    for (le_sls_Link_t* linkPtr = le_sls_Peek(&RequestQueue);
+         linkPtr != NULL;
+         linkPtr = le_sls_PeekNext(&RequestQueue, linkPtr))
+    {
+        ForgetSession(CONTAINER_OF(linkPtr, Request_t, link), sessionRef);
+    }
+
+    for (le_sls_Link_t* linkPtr = le_sls_Peek(&PulseRequests);
+         linkPtr != NULL;
+         linkPtr = le_sls_PeekNext(&PulseRequests, linkPtr))
+    {
+        ForgetSession(CONTAINER_OF(linkPtr, Request_t, link), sessionRef);
+    }
+
+    muxState_SessionClosed(sessionRef);
+    scheduler_SessionClosed(sessionRef);
+    lease_SessionClosed(sessionRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Disable UART 1
  *
  * @return
  *      - LE_FAULT
- *      - LE_UNSUPPORTED if the board doesn't have an Arduino
  *      - LE_OK
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t mangoh_muxCtrl_ArduinoReset
+void mangoh_muxCtrl_IotAllUart1Off
 (
-    void
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
 )
 {
-    le_result_t res;
+    QueueOperation(MANGOH_MUXCTRL_OP_IOT_ALL_UART1_OFF,
+                   cmdRef,
+                   mangoh_muxCtrl_IotAllUart1OffRespond);
+}
 
-    res = mangoh_muxCtrl_ArduinoAssertReset();
-    if(res != LE_OK)
-    {
-        return res;
-    }
+//--------------------------------------------------------------------------------------------------
+/**
+ * Enable UART 1 on IoT slot 0
+ *
+ * @return
+ *      - LE_FAULT
+ *      - LE_OK
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_Iot0Uart1On
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    QueueOperation(MANGOH_MUXCTRL_OP_IOT0_UART1_ON, cmdRef, mangoh_muxCtrl_Iot0Uart1OnRespond);
+}
 
-    usleep(300);
+//--------------------------------------------------------------------------------------------------
+/**
+ * Enable UART 1 on IoT slot 1
+ *
+ * @return
+ *      - LE_FAULT
+ *      - LE_OK
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_Iot1Uart1On
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    QueueOperation(MANGOH_MUXCTRL_OP_IOT1_UART1_ON, cmdRef, mangoh_muxCtrl_Iot1Uart1OnRespond);
+}
 
-    res = mangoh_muxCtrl_ArduinoDeassertReset();
+//--------------------------------------------------------------------------------------------------
+/**
+ * Disable SPI
+ *
+ * @return
+ *      - LE_FAULT
+ *      - LE_OK
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_IotAllSpiOff
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    QueueOperation(MANGOH_MUXCTRL_OP_IOT_ALL_SPI_OFF, cmdRef, mangoh_muxCtrl_IotAllSpiOffRespond);
+}
 
-    return res;
+//--------------------------------------------------------------------------------------------------
+/**
+ * Enable SPI on IoT slot 0
+ *
+ * @return
+ *      - LE_FAULT
+ *      - LE_OK
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_Iot0Spi1On
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    QueueOperation(MANGOH_MUXCTRL_OP_IOT0_SPI1_ON, cmdRef, mangoh_muxCtrl_Iot0Spi1OnRespond);
 }
 
-COMPONENT_INIT
+//--------------------------------------------------------------------------------------------------
+/**
+ * Mux Control: mangOH IOT1 SPI1 ON.
+ *
+ * @return
+ *      - LE_FAULT
+ *      - LE_OK
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_Iot1Spi1On
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    QueueOperation(MANGOH_MUXCTRL_OP_IOT1_SPI1_ON, cmdRef, mangoh_muxCtrl_Iot1Spi1OnRespond);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Disable UART 2
+ *
+ * @return
+ *      - LE_FAULT
+ *      - LE_OK
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_IotAllUart2Off
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    QueueOperation(MANGOH_MUXCTRL_OP_IOT_ALL_UART2_OFF,
+                   cmdRef,
+                   mangoh_muxCtrl_IotAllUart2OffRespond);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Enable UART 2 on IoT slot 2
+ *
+ * @return
+ *      - LE_FAULT
+ *      - LE_OK
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_Iot2Uart2On
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    QueueOperation(MANGOH_MUXCTRL_OP_IOT2_UART2_ON, cmdRef, mangoh_muxCtrl_Iot2Uart2OnRespond);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Enable UART 2 on the debug port
+ *
+ * @return
+ *      - LE_FAULT
+ *      - LE_OK
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_Uart2DebugOn
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    QueueOperation(MANGOH_MUXCTRL_OP_UART2_DEBUG_ON, cmdRef, mangoh_muxCtrl_Uart2DebugOnRespond);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Connect the SDIO interface to the MicroSD card slot
+ *
+ * @return
+ *      - LE_FAULT
+ *      - LE_OK
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_SdioSelMicroSd
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    QueueOperation(MANGOH_MUXCTRL_OP_SDIO_SEL_MICRO_SD,
+                   cmdRef,
+                   mangoh_muxCtrl_SdioSelMicroSdRespond);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Connect the SDIO interface to IoT slot 0
+ *
+ * @return
+ *      - LE_FAULT
+ *      - LE_OK
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_SdioSelIot0
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    QueueOperation(MANGOH_MUXCTRL_OP_SDIO_SEL_IOT0, cmdRef, mangoh_muxCtrl_SdioSelIot0Respond);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Disable the audio path
+ *
+ * @return
+ *      LE_OK on success or LE_FAULT on failure
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_AudioDisable
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    QueueOperation(MANGOH_MUXCTRL_OP_AUDIO_DISABLE, cmdRef, mangoh_muxCtrl_AudioDisableRespond);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Route audio via a codec installed in IoT slot 0
+ *
+ * @return
+ *      LE_OK on success or LE_FAULT on failure
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_AudioSelectIot0Codec
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    QueueOperation(MANGOH_MUXCTRL_OP_AUDIO_SELECT_IOT0_CODEC,
+                   cmdRef,
+                   mangoh_muxCtrl_AudioSelectIot0CodecRespond);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Route audio via the codec on the mangOH board
+ *
+ * @return
+ *      LE_OK on success or LE_FAULT on failure
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_AudioSelectOnboardCodec
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    QueueOperation(MANGOH_MUXCTRL_OP_AUDIO_SELECT_ONBOARD_CODEC,
+                   cmdRef,
+                   mangoh_muxCtrl_AudioSelectOnboardCodecRespond);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Route audio via a codec internal to the CF3 module
+ *
+ * @return
+ *      LE_OK on success or LE_FAULT on failure
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_AudioSelectInternalCodec
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    QueueOperation(MANGOH_MUXCTRL_OP_AUDIO_SELECT_INTERNAL_CODEC,
+                   cmdRef,
+                   mangoh_muxCtrl_AudioSelectInternalCodecRespond);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Take IoT slot 0 card out of reset
+ *
+ * @return
+ *      - LE_FAULT
+ *      - LE_OK
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_IotSlot0DeassertReset
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    QueueOperation(MANGOH_MUXCTRL_OP_IOT_SLOT0_DEASSERT_RESET,
+                   cmdRef,
+                   mangoh_muxCtrl_IotSlot0DeassertResetRespond);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Take IoT slot 1 card out of reset
+ *
+ * @return
+ *      - LE_FAULT
+ *      - LE_OK
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_IotSlot1DeassertReset
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    QueueOperation(MANGOH_MUXCTRL_OP_IOT_SLOT1_DEASSERT_RESET,
+                   cmdRef,
+                   mangoh_muxCtrl_IotSlot1DeassertResetRespond);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Take IoT slot 2 card out of reset
+ *
+ * @return
+ *      - LE_FAULT
+ *      - LE_OK
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_IotSlot2DeassertReset
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    QueueOperation(MANGOH_MUXCTRL_OP_IOT_SLOT2_DEASSERT_RESET,
+                   cmdRef,
+                   mangoh_muxCtrl_IotSlot2DeassertResetRespond);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Put Arduino in reset state
+ *
+ * @return
+ *      - LE_FAULT
+ *      - LE_UNSUPPORTED if the board doesn't have an Arduino
+ *      - LE_OK
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_ArduinoAssertReset
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    QueueOperation(MANGOH_MUXCTRL_OP_ARDUINO_ASSERT_RESET,
+                   cmdRef,
+                   mangoh_muxCtrl_ArduinoAssertResetRespond);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Put Arduino out of reset state
+ *
+ * @return
+ *      - LE_FAULT
+ *      - LE_UNSUPPORTED if the board doesn't have an Arduino
+ *      - LE_OK
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_ArduinoDeassertReset
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    QueueOperation(MANGOH_MUXCTRL_OP_ARDUINO_DEASSERT_RESET,
+                   cmdRef,
+                   mangoh_muxCtrl_ArduinoDeassertResetRespond);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Perform Arduino reset
+ *
+ * @return
+ *      - LE_FAULT
+ *      - LE_UNSUPPORTED if the board doesn't have an Arduino
+ *      - LE_OK
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_ArduinoReset
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    QueueOperation(MANGOH_MUXCTRL_OP_ARDUINO_RESET, cmdRef, mangoh_muxCtrl_ArduinoResetRespond);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Put a target in reset and take it out of reset again once its reset pulse width has elapsed.
+ * The response is sent when the target is out of reset.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_PulseReset
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef,
+    mangoh_muxCtrl_ResetTarget_t target    ///< Target to reset
+)
+{
+    Request_t* requestPtr = NewRequest(REQUEST_PULSE);
+
+    requestPtr->params.target = target;
+    QueueRequest(requestPtr, cmdRef, mangoh_muxCtrl_PulseResetRespond);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the width of the reset pulses of a target.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_SetResetPulseWidth
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef,
+    mangoh_muxCtrl_ResetTarget_t target,   ///< Target whose pulse width to set
+    uint32_t widthUs                       ///< Pulse width in microseconds
+)
+{
+    mangoh_muxCtrl_SetResetPulseWidthRespond(cmdRef, resetPulse_SetWidth(target, widthUs));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fill in the routing of a REQUEST_CONFIGURATION request.
+ */
+//--------------------------------------------------------------------------------------------------
+static Request_t* NewConfigurationRequest
+(
+    mangoh_muxCtrl_Uart1Route_t uart1,  ///< UART 1 route
+    mangoh_muxCtrl_SpiRoute_t spi,      ///< SPI route
+    mangoh_muxCtrl_Uart2Route_t uart2,  ///< UART 2 route
+    mangoh_muxCtrl_SdioRoute_t sdio,    ///< SDIO route
+    mangoh_muxCtrl_AudioRoute_t audio   ///< Audio route
+)
+{
+    Request_t* requestPtr = NewRequest(REQUEST_CONFIGURATION);
+
+    requestPtr->params.config.uart1 = uart1;
+    requestPtr->params.config.spi = spi;
+    requestPtr->params.config.uart2 = uart2;
+    requestPtr->params.config.sdio = sdio;
+    requestPtr->params.config.audio = audio;
+
+    return requestPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Apply a complete routing of the muxes in a single request.  Only the pins that differ from their
+ * current state are written.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_ApplyConfiguration
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef,
+    mangoh_muxCtrl_Uart1Route_t uart1,  ///< UART 1 route
+    mangoh_muxCtrl_SpiRoute_t spi,      ///< SPI route
+    mangoh_muxCtrl_Uart2Route_t uart2,  ///< UART 2 route
+    mangoh_muxCtrl_SdioRoute_t sdio,    ///< SDIO route
+    mangoh_muxCtrl_AudioRoute_t audio   ///< Audio route
+)
+{
+    QueueRequest(NewConfigurationRequest(uart1, spi, uart2, sdio, audio),
+                 cmdRef,
+                 mangoh_muxCtrl_ApplyConfigurationRespond);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run a sequence of operations, in order, in a single request.  The sequence stops at the first
+ * operation that fails.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_ExecuteSequence
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef,
+    const mangoh_muxCtrl_Operation_t* opsPtr,  ///< Operations to run
+    size_t opsSize                             ///< Number of operations
+)
+{
+    if (opsSize > MANGOH_MUXCTRL_MAX_SEQUENCE_LEN)
+    {
+        mangoh_muxCtrl_ExecuteSequenceRespond(cmdRef, LE_BAD_PARAMETER, -1);
+        return;
+    }
+
+    Request_t* requestPtr = NewRequest(REQUEST_SEQUENCE);
+    memcpy(requestPtr->params.sequence.ops, opsPtr, opsSize * sizeof(opsPtr[0]));
+    requestPtr->params.sequence.numOps = opsSize;
+    requestPtr->params.sequence.current = 0;
+
+    QueueRequest(requestPtr, cmdRef, NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queue an operation and return straight away.  The handler is called when it is complete.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_ExecuteAsync
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef,
+    mangoh_muxCtrl_Operation_t op,                      ///< Operation to run
+    mangoh_muxCtrl_CompletionHandlerFunc_t handlerPtr,  ///< Completion handler
+    void* contextPtr                                    ///< Context of the handler
+)
+{
+    Request_t* requestPtr = NewRequest(REQUEST_OPERATION);
+
+    requestPtr->params.op = op;
+    mangoh_muxCtrl_ExecuteAsyncRespond(cmdRef);
+    QueueAsyncRequest(requestPtr, handlerPtr, contextPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queue a complete routing of the muxes and return straight away.  The handler is called when it
+ * has been applied.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_ApplyConfigurationAsync
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef,
+    mangoh_muxCtrl_Uart1Route_t uart1,                  ///< UART 1 route
+    mangoh_muxCtrl_SpiRoute_t spi,                      ///< SPI route
+    mangoh_muxCtrl_Uart2Route_t uart2,                  ///< UART 2 route
+    mangoh_muxCtrl_SdioRoute_t sdio,                    ///< SDIO route
+    mangoh_muxCtrl_AudioRoute_t audio,                  ///< Audio route
+    mangoh_muxCtrl_CompletionHandlerFunc_t handlerPtr,  ///< Completion handler
+    void* contextPtr                                    ///< Context of the handler
+)
+{
+    Request_t* requestPtr = NewConfigurationRequest(uart1, spi, uart2, sdio, audio);
+
+    mangoh_muxCtrl_ApplyConfigurationAsyncRespond(cmdRef);
+    QueueAsyncRequest(requestPtr, handlerPtr, contextPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queue a reset pulse and return straight away.  The handler is called when the target is out of
+ * reset.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_PulseResetAsync
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef,
+    mangoh_muxCtrl_ResetTarget_t target,                ///< Target to reset
+    mangoh_muxCtrl_CompletionHandlerFunc_t handlerPtr,  ///< Completion handler
+    void* contextPtr                                    ///< Context of the handler
+)
+{
+    Request_t* requestPtr = NewRequest(REQUEST_PULSE);
+
+    requestPtr->params.target = target;
+    mangoh_muxCtrl_PulseResetAsyncRespond(cmdRef);
+    QueueAsyncRequest(requestPtr, handlerPtr, contextPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the pin state cache counters.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_GetPinCacheStats
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    uint32_t hits;
+    uint32_t misses;
+
+    pinState_GetCacheStats(&hits, &misses);
+    mangoh_muxCtrl_GetPinCacheStatsRespond(cmdRef, hits, misses);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of writes made to the GPIO expanders.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_GetExpanderWriteCount
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    mangoh_muxCtrl_GetExpanderWriteCountRespond(cmdRef, pinState_GetWriteCount());
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of bus transactions made to the GPIO expanders.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_GetBusTransactionCount
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    uint32_t count = 0;
+    le_result_t result = pinState_GetBusTransactionCount(&count);
+
+    mangoh_muxCtrl_GetBusTransactionCountRespond(cmdRef, result, count);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Forget the cached state of every pin, so that the next request rewrites each pin it touches.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_InvalidatePinCache
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    pinState_Invalidate();
+    mangoh_muxCtrl_InvalidatePinCacheRespond(cmdRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get statistics about the request queue.  Times are in microseconds.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_GetQueueStats
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    uint32_t started = QueueStats.completed + ((ActiveRequestPtr != NULL) ? 1 : 0);
+
+    mangoh_muxCtrl_GetQueueStatsRespond(
+        cmdRef,
+        QueueStats.depth,
+        QueueStats.maxDepth,
+        QueueStats.rejected,
+        QueueStats.completed,
+        (started == 0) ? 0 : (uint32_t)(QueueStats.totalWaitUs / started),
+        QueueStats.maxWaitUs,
+        (QueueStats.completed == 0) ?
+            0 : (uint32_t)(QueueStats.totalServiceUs / QueueStats.completed),
+        QueueStats.maxServiceUs);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the coalescing window.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_SetCoalescingWindow
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef,
+    uint32_t windowUs                      ///< Coalescing window in microseconds, or 0
+)
+{
+    if (windowUs > MANGOH_MUXCTRL_MAX_COALESCING_WINDOW_US)
+    {
+        mangoh_muxCtrl_SetCoalescingWindowRespond(cmdRef, LE_OUT_OF_RANGE);
+        return;
+    }
+
+    CoalescingWindowUs = windowUs;
+    mangoh_muxCtrl_SetCoalescingWindowRespond(cmdRef, LE_OK);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the coalescing window and the number of transitions it has skipped.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_GetCoalescingStats
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    mangoh_muxCtrl_GetCoalescingStatsRespond(cmdRef, CoalescingWindowUs, CoalescedCount);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Register a handler to be called when a mux or reset line changes position.
+ */
+//--------------------------------------------------------------------------------------------------
+mangoh_muxCtrl_StateChangeHandlerRef_t mangoh_muxCtrl_AddStateChangeHandler
+(
+    mangoh_muxCtrl_StateChangeHandlerFunc_t handlerPtr,  ///< Handler to call
+    void* contextPtr                                     ///< Passed to the handler
+)
+{
+    return muxState_AddHandler(handlerPtr, contextPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove a handler registered with mangoh_muxCtrl_AddStateChangeHandler().
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_RemoveStateChangeHandler
+(
+    mangoh_muxCtrl_StateChangeHandlerRef_t handlerRef  ///< Handler to remove
+)
+{
+    muxState_RemoveHandler(handlerRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Take the lease on a mux.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_AcquireBus
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef,
+    mangoh_muxCtrl_MuxGroup_t group         ///< Mux to lease
+)
+{
+    mangoh_muxCtrl_AcquireBusRespond(cmdRef,
+                                     lease_Acquire(group, mangoh_muxCtrl_GetClientSessionRef()));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Give up the lease on a mux.  The lease taken by a schedule is only given up with the schedule
+ * (see StopSchedule()), so that the schedule never switches a bus that another client holds.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_ReleaseBus
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef,
+    mangoh_muxCtrl_MuxGroup_t group         ///< Mux to give up
+)
+{
+    le_msg_SessionRef_t sessionRef = mangoh_muxCtrl_GetClientSessionRef();
+
+    if (scheduler_IsRunning(group, sessionRef))
+    {
+        LE_ERROR("Mux group %d can't be released while its schedule is running", group);
+        mangoh_muxCtrl_ReleaseBusRespond(cmdRef, LE_BUSY);
+        return;
+    }
+
+    mangoh_muxCtrl_ReleaseBusRespond(cmdRef, lease_Release(group, sessionRef));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Register a handler to be called when the lease on a mux is given up.
+ */
+//--------------------------------------------------------------------------------------------------
+mangoh_muxCtrl_BusReleasedHandlerRef_t mangoh_muxCtrl_AddBusReleasedHandler
+(
+    mangoh_muxCtrl_BusReleasedHandlerFunc_t handlerPtr,  ///< Handler to call
+    void* contextPtr                                     ///< Passed to the handler
+)
+{
+    return lease_AddHandler(handlerPtr, contextPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove a handler registered with mangoh_muxCtrl_AddBusReleasedHandler().
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_RemoveBusReleasedHandler
+(
+    mangoh_muxCtrl_BusReleasedHandlerRef_t handlerRef  ///< Handler to remove
+)
+{
+    lease_RemoveHandler(handlerRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start sharing UART 1 or SPI between IoT slots 0 and 1 on a repeating schedule.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_StartSchedule
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef,
+    mangoh_muxCtrl_MuxGroup_t bus,      ///< MUX_UART1 or MUX_SPI
+    const uint8_t* slotsPtr,            ///< IoT slot of each slice
+    size_t slotsSize,
+    const uint32_t* slicesMsPtr,        ///< Length of each slice in milliseconds
+    size_t slicesMsSize,
+    uint32_t guardMs                    ///< Time between SLOT_ENDING and the switch
+)
+{
+    mangoh_muxCtrl_StartScheduleRespond(cmdRef,
+                                        scheduler_Start(bus,
+                                                        slotsPtr, slotsSize,
+                                                        slicesMsPtr, slicesMsSize,
+                                                        guardMs,
+                                                        mangoh_muxCtrl_GetClientSessionRef()));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the schedule started by the client on a bus.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_StopSchedule
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef,
+    mangoh_muxCtrl_MuxGroup_t bus       ///< MUX_UART1 or MUX_SPI
+)
+{
+    mangoh_muxCtrl_StopScheduleRespond(cmdRef,
+                                       scheduler_Stop(bus, mangoh_muxCtrl_GetClientSessionRef()));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Register a handler to be called at the slot boundaries of the schedules.
+ */
+//--------------------------------------------------------------------------------------------------
+mangoh_muxCtrl_SlotSwitchHandlerRef_t mangoh_muxCtrl_AddSlotSwitchHandler
+(
+    mangoh_muxCtrl_SlotSwitchHandlerFunc_t handlerPtr,  ///< Handler to call
+    void* contextPtr                                    ///< Passed to the handler
+)
+{
+    return scheduler_AddHandler(handlerPtr, contextPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove a handler registered with mangoh_muxCtrl_AddSlotSwitchHandler().
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_RemoveSlotSwitchHandler
+(
+    mangoh_muxCtrl_SlotSwitchHandlerRef_t handlerRef  ///< Handler to remove
+)
+{
+    scheduler_RemoveHandler(handlerRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the current position of a mux or reset line from the pin state cache.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_GetPosition
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef,
+    mangoh_muxCtrl_MuxGroup_t group         ///< Mux or reset line
+)
+{
+    int32_t positions[MUX_STATE_NUM_GROUPS];
+
+    if ((group < 0) || (group >= MUX_STATE_NUM_GROUPS))
+    {
+        LE_ERROR("Invalid mux group (%d)", group);
+        mangoh_muxCtrl_GetPositionRespond(cmdRef, LE_BAD_PARAMETER, -1);
+        return;
+    }
+
+    muxState_GetPositions(positions);
+    mangoh_muxCtrl_GetPositionRespond(
+        cmdRef, (positions[group] < 0) ? LE_UNAVAILABLE : LE_OK, positions[group]);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the current routing of all the muxes from the pin state cache.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_GetRouting
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    int32_t positions[MUX_STATE_NUM_GROUPS];
+    le_result_t result = LE_OK;
+
+    muxState_GetPositions(positions);
+    for (int group = MANGOH_MUXCTRL_MUX_UART1; group <= MANGOH_MUXCTRL_MUX_AUDIO; group++)
+    {
+        if (positions[group] < 0)
+        {
+            result = LE_UNAVAILABLE;
+        }
+    }
+
+    mangoh_muxCtrl_GetRoutingRespond(cmdRef,
+                                     result,
+                                     positions[MANGOH_MUXCTRL_MUX_UART1],
+                                     positions[MANGOH_MUXCTRL_MUX_SPI],
+                                     positions[MANGOH_MUXCTRL_MUX_UART2],
+                                     positions[MANGOH_MUXCTRL_MUX_SDIO],
+                                     positions[MANGOH_MUXCTRL_MUX_AUDIO]);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get which targets are held in reset from the pin state cache.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_GetResetState
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    int32_t positions[MUX_STATE_NUM_GROUPS];
+    le_result_t result = LE_OK;
+
+    muxState_GetPositions(positions);
+    for (int group = MANGOH_MUXCTRL_MUX_RESET_IOT0;
+         group <= MANGOH_MUXCTRL_MUX_RESET_ARDUINO;
+         group++)
+    {
+        if (positions[group] < 0)
+        {
+            result = LE_UNAVAILABLE;
+        }
+    }
+
+    mangoh_muxCtrl_GetResetStateRespond(cmdRef,
+                                        result,
+                                        positions[MANGOH_MUXCTRL_MUX_RESET_IOT0] == 1,
+                                        positions[MANGOH_MUXCTRL_MUX_RESET_IOT1] == 1,
+                                        positions[MANGOH_MUXCTRL_MUX_RESET_IOT2] == 1,
+                                        positions[MANGOH_MUXCTRL_MUX_RESET_ARDUINO] == 1);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the statistics of an API call.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_GetCallStats
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef,
+    uint32_t index
+)
+{
+    const char* namePtr = "";
+    uint32_t calls = 0;
+    uint32_t failures = 0;
+
+    le_result_t result = stats_GetCall(index, &namePtr, &calls, &failures);
+    mangoh_muxCtrl_GetCallStatsRespond(cmdRef, result, namePtr, calls, failures);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the statistics of a GPIO pin.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_GetPinStats
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef,
+    uint32_t index
+)
+{
+    const char* namePtr = "";
+    uint32_t writes = 0;
+    uint32_t failures = 0;
+
+    le_result_t result = stats_GetPin(index, &namePtr, &writes, &failures);
+    mangoh_muxCtrl_GetPinStatsRespond(cmdRef, result, namePtr, writes, failures);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the latency histogram of the calls made to the GPIO backend.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_GetGpioLatencyHistogram
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    uint32_t buckets[MANGOH_MUXCTRL_NUM_LATENCY_BUCKETS];
+    uint32_t maxUs;
+
+    stats_GetGpioLatency(buckets, &maxUs);
+    mangoh_muxCtrl_GetGpioLatencyHistogramRespond(cmdRef, buckets, NUM_ARRAY_MEMBERS(buckets),
+                                                  maxUs);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reset the call, pin and GPIO latency statistics to zero.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_ResetStats
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef
+)
+{
+    stats_Reset();
+    mangoh_muxCtrl_ResetStatsRespond(cmdRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read entries from the trace of pin writes.
+ */
+//--------------------------------------------------------------------------------------------------
+void mangoh_muxCtrl_ReadTrace
+(
+    mangoh_muxCtrl_ServerCmdRef_t cmdRef,
+    uint32_t startSeq
+)
+{
+    trace_Entry_t entries[MANGOH_MUXCTRL_TRACE_BATCH_LEN];
+    uint32_t seqs[MANGOH_MUXCTRL_TRACE_BATCH_LEN];
+    uint64_t timesNs[MANGOH_MUXCTRL_TRACE_BATCH_LEN];
+    int32_t clients[MANGOH_MUXCTRL_TRACE_BATCH_LEN];
+    uint32_t calls[MANGOH_MUXCTRL_TRACE_BATCH_LEN];
+    uint8_t pins[MANGOH_MUXCTRL_TRACE_BATCH_LEN];
+    bool values[MANGOH_MUXCTRL_TRACE_BATCH_LEN];
+    int32_t results[MANGOH_MUXCTRL_TRACE_BATCH_LEN];
+
+    size_t count = trace_Read(startSeq, entries, NUM_ARRAY_MEMBERS(entries));
+    for (size_t i = 0; i < count; i++)
+    {
+        seqs[i] = entries[i].seq;
+        timesNs[i] = entries[i].timeNs;
+        clients[i] = entries[i].client;
+        calls[i] = entries[i].call;
+        pins[i] = entries[i].pin;
+        values[i] = entries[i].value;
+        results[i] = entries[i].result;
+    }
+
+    uint32_t nextSeq = (count > 0) ? (entries[count - 1].seq + 1) : startSeq;
+
+    mangoh_muxCtrl_ReadTraceRespond(cmdRef, seqs, count, timesNs, count, clients, count,
+                                    calls, count, pins, count, values, count, results, count,
+                                    nextSeq);
+}
+
+COMPONENT_INIT
 {
     LE_INFO(
         "This is sample mangOH Mux Control API service by using mangoh_gpioExpander.api and "
         "mangoh_muxCtrl.api\n");
 
-    mangoh_gpioPinUart1Enable_SetPushPullOutput(MANGOH_GPIOPINUART1ENABLE_ACTIVE_LOW, false);
-    mangoh_gpioPinUart1Select_SetPushPullOutput(MANGOH_GPIOPINUART1SELECT_ACTIVE_HIGH, false);
-    mangoh_gpioPinSpiEnable_SetPushPullOutput(MANGOH_GPIOPINSPIENABLE_ACTIVE_LOW, false);
-    mangoh_gpioPinSpiSelect_SetPushPullOutput(MANGOH_GPIOPINSPISELECT_ACTIVE_HIGH, false);
-    mangoh_gpioPinUart2Enable_SetPushPullOutput(MANGOH_GPIOPINUART2ENABLE_ACTIVE_LOW, true);
-    mangoh_gpioPinUart2Select_SetPushPullOutput(MANGOH_GPIOPINUART2SELECT_ACTIVE_HIGH, false);
-    mangoh_gpioPinPcmEnable_SetPushPullOutput(MANGOH_GPIOPINPCMENABLE_ACTIVE_LOW, false);
-    mangoh_gpioPinPcmSelect_SetPushPullOutput(MANGOH_GPIOPINPCMSELECT_ACTIVE_HIGH, false);
-    mangoh_gpioPinSdioSelect_SetPushPullOutput(MANGOH_GPIOPINSDIOSELECT_ACTIVE_HIGH, true);
-    mangoh_gpioPinPcmAnalogSelect_SetPushPullOutput(
-        MANGOH_GPIOPINPCMANALOGSELECT_ACTIVE_HIGH, false);
-    mangoh_gpioPinIot0Reset_SetPushPullOutput(MANGOH_GPIOPINIOT0RESET_ACTIVE_LOW, true);
-    mangoh_gpioPinIot1Reset_SetPushPullOutput(MANGOH_GPIOPINIOT1RESET_ACTIVE_LOW, true);
-    mangoh_gpioPinIot2Reset_SetPushPullOutput(MANGOH_GPIOPINIOT2RESET_ACTIVE_LOW, true);
-    mangoh_gpioPinArduinoReset_SetPushPullOutput(MANGOH_GPIOPINARDUINORESET_ACTIVE_LOW, true);
+    RequestPool = le_mem_CreatePool("Requests", sizeof(Request_t));
+    CoalescingTimer = le_timer_Create("Coalescing window");
+    le_timer_SetHandler(CoalescingTimer, CoalescingTimerExpired);
+    le_msg_AddServiceCloseHandler(mangoh_muxCtrl_GetServiceRef(), SessionClosed, NULL);
+
+    // After a restart, keep the state the previous instance left, rather than the defaults.
+    // pinState_Init() reads it back from the pins where it can, and takes it from the state page
+    // for the pins it can't read.  The boot profile fills in whatever was not recovered, so on a
+    // cold start the pins are configured straight into the profile's routing.
+    pinState_Transition_t start;
+    pinState_StartTransition(&start, false);
+    le_result_t result = muxState_Recover(&start);
+    switch (result)
+    {
+        case LE_OK:
+            LE_INFO("Warm start: recovered the state of %d pins", __builtin_popcount(start.mask));
+            break;
+        case LE_NOT_FOUND:
+            LE_INFO("Cold start");
+            break;
+        default:
+            LE_WARN("Warm start: no usable state snapshot, reading the pins back instead");
+            break;
+    }
+    if (bootProfile_Load(&start) == LE_OK)
+    {
+        LE_INFO("Applied the boot profile");
+    }
+
+    worker_Init(&start, result != LE_NOT_FOUND);
+    muxState_Init();
+    resetPulse_Init();
+    lease_Init();
+    scheduler_Init(QueueScheduledSwitch);
 }
@@ -0,0 +1,374 @@
+/**
+ * @file muxState.c
+ *
+ * Position of each mux and reset line, worked out from the pin state cache, and the StateChange
+ * event that reports changes to it.
+ *
+ * Positions are worked out from the pins rather than from the requests that set them, so every
+ * path that changes a pin (single operations, sequences, configurations and reset pulses) is
+ * reported the same way.  A group with a pin in an unknown state is not reported until its state
+ * is known again.
+ *
+ * The same state is published in a shared-memory page (see muxStatePage.h), so that clients that
+ * only want to look at it can do so without any IPC.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+#include <sys/mman.h>
+
+#include "pinState.h"
+#include "routing.h"
+#include "muxState.h"
+#include "muxStatePage.h"
+#include "sessionHandlers.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report sent through the StateChange event.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    mangoh_muxCtrl_MuxGroup_t group;
+    int32_t position;
+}
+StateChange_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Last reported position of each group, and whether there is one.
+ */
+//--------------------------------------------------------------------------------------------------
+static struct
+{
+    bool known;
+    int32_t position;
+}
+Positions[MUX_STATE_NUM_GROUPS];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Event used to report state changes.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_event_Id_t StateChangeEventId;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Registered StateChange handlers.
+ */
+//--------------------------------------------------------------------------------------------------
+static sessionHandlers_List_t Handlers;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The shared-memory state page, or NULL if it could not be created.
+ */
+//--------------------------------------------------------------------------------------------------
+static muxStatePage_Layout_t* PagePtr;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pass a state change on to a client's handler.
+ */
+//--------------------------------------------------------------------------------------------------
+static void FirstLayerStateChangeHandler
+(
+    void* reportPtr,
+    void* secondLayerHandlerFunc
+)
+{
+    const StateChange_t* changePtr = reportPtr;
+    mangoh_muxCtrl_StateChangeHandlerFunc_t clientHandlerFunc = secondLayerHandlerFunc;
+
+    clientHandlerFunc(changePtr->group, changePtr->position, le_event_GetContextPtr());
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Create and map the shared-memory state page.  The service works without it, so failures are
+ * only logged.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CreatePage
+(
+    void
+)
+{
+    int fd = shm_open(MUX_STATE_PAGE_NAME, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd < 0)
+    {
+        LE_ERROR("Failed to create the mux state page (%m)");
+        return;
+    }
+
+    if (ftruncate(fd, sizeof(muxStatePage_Layout_t)) != 0)
+    {
+        LE_ERROR("Failed to size the mux state page (%m)");
+        close(fd);
+        return;
+    }
+
+    void* mapPtr = mmap(NULL,
+                        sizeof(muxStatePage_Layout_t),
+                        PROT_READ | PROT_WRITE,
+                        MAP_SHARED,
+                        fd,
+                        0);
+    close(fd);
+    if (mapPtr == MAP_FAILED)
+    {
+        LE_ERROR("Failed to map the mux state page (%m)");
+        return;
+    }
+
+    PagePtr = mapPtr;
+
+    // Keep counting from where a previous instance of the service left off, so the sequence
+    // number of a reader that kept the page mapped across a restart never goes backwards.
+    uint32_t sequence = (PagePtr->magic == MUX_STATE_PAGE_MAGIC) ?
+                        ((__atomic_load_n(&PagePtr->sequence, __ATOMIC_RELAXED) + 1) & ~1u) : 0;
+    __atomic_store_n(&PagePtr->sequence, sequence, __ATOMIC_RELAXED);
+    PagePtr->version = MUX_STATE_PAGE_VERSION;
+    PagePtr->magic = MUX_STATE_PAGE_MAGIC;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Publish the state of the pins in the shared-memory state page.
+ */
+//--------------------------------------------------------------------------------------------------
+static void PublishPage
+(
+    uint32_t knownMask,
+    uint32_t activeMask
+)
+{
+    if (PagePtr == NULL)
+    {
+        return;
+    }
+
+    muxStatePage_Snapshot_t snapshot =
+    {
+        .knownMask = knownMask,
+        .activeMask = activeMask,
+        .updateCount = PagePtr->snapshot.updateCount + 1
+    };
+    for (int group = 0; group < MUX_STATE_NUM_GROUPS; group++)
+    {
+        if (routing_GetPosition(group, knownMask, activeMask, &snapshot.positions[group]) != LE_OK)
+        {
+            snapshot.positions[group] = -1;
+        }
+    }
+
+    // Sequence lock: odd while the snapshot is being written.
+    uint32_t sequence = __atomic_load_n(&PagePtr->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&PagePtr->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    memcpy(&PagePtr->snapshot, &snapshot, sizeof(snapshot));
+
+    __atomic_store_n(&PagePtr->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Recover the pin states left by a previous instance of the service from the shared-memory state
+ * page, which outlives the service.  Must be called before muxState_Init().
+ *
+ * The page is published after each write completes, so it can be one transition behind the pins;
+ * pinState_Init() only uses it for the pins it can't read back.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_NOT_FOUND if there is no page, i.e. this is the first start since boot
+ *      - LE_FAULT if the page could not be read
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t muxState_Recover
+(
+    pinState_Transition_t* transitionPtr  ///< Transition to add the recovered pin states to
+)
+{
+    le_result_t result = muxStatePage_Open();
+    if (result == LE_UNAVAILABLE)
+    {
+        return LE_NOT_FOUND;
+    }
+    if (result != LE_OK)
+    {
+        return LE_FAULT;
+    }
+
+    muxStatePage_Snapshot_t snapshot;
+    result = muxStatePage_Read(&snapshot);
+    muxStatePage_Close();
+    if (result != LE_OK)
+    {
+        LE_ERROR("Failed to read the mux state page (%d)", result);
+        return LE_FAULT;
+    }
+
+    for (int pin = 0; pin < PIN_COUNT; pin++)
+    {
+        if (snapshot.knownMask & (1 << pin))
+        {
+            pinState_AddPin(transitionPtr, pin, (snapshot.activeMask & (1 << pin)) != 0);
+        }
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Create the StateChange event and record the current positions.  Must be called after the pins
+ * have been configured.
+ */
+//--------------------------------------------------------------------------------------------------
+void muxState_Init
+(
+    void
+)
+{
+    LE_ASSERT(MUX_STATE_NUM_GROUPS == MUX_STATE_PAGE_NUM_GROUPS);
+
+    StateChangeEventId = le_event_CreateId("Mux state change", sizeof(StateChange_t));
+    sessionHandlers_Init(&Handlers, "state change", StateChangeEventId,
+                         FirstLayerStateChangeHandler);
+
+    uint32_t knownMask;
+    uint32_t activeMask;
+    pinState_GetSnapshot(&knownMask, &activeMask);
+
+    CreatePage();
+    PublishPage(knownMask, activeMask);
+
+    for (int group = 0; group < MUX_STATE_NUM_GROUPS; group++)
+    {
+        Positions[group].known =
+            (routing_GetPosition(group, knownMask, activeMask, &Positions[group].position) ==
+             LE_OK);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compare the current positions with the last reported ones and report each group that has
+ * changed.  Called on the main thread after each transition is committed.
+ */
+//--------------------------------------------------------------------------------------------------
+void muxState_Update
+(
+    void
+)
+{
+    uint32_t knownMask;
+    uint32_t activeMask;
+    pinState_GetSnapshot(&knownMask, &activeMask);
+
+    PublishPage(knownMask, activeMask);
+
+    for (int group = 0; group < MUX_STATE_NUM_GROUPS; group++)
+    {
+        int32_t position;
+        if (routing_GetPosition(group, knownMask, activeMask, &position) != LE_OK)
+        {
+            continue;
+        }
+
+        if (Positions[group].known && (Positions[group].position == position))
+        {
+            continue;
+        }
+
+        Positions[group].known = true;
+        Positions[group].position = position;
+
+        StateChange_t change = { .group = group, .position = position };
+        le_event_Report(StateChangeEventId, &change, sizeof(change));
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the current position of every group from one snapshot of the pin state cache.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_UNAVAILABLE if the position of at least one group is not known; its entry is set to -1
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t muxState_GetPositions
+(
+    int32_t positions[MUX_STATE_NUM_GROUPS]  ///< [OUT] Position of each group
+)
+{
+    le_result_t result = LE_OK;
+    uint32_t knownMask;
+    uint32_t activeMask;
+    pinState_GetSnapshot(&knownMask, &activeMask);
+
+    for (int group = 0; group < MUX_STATE_NUM_GROUPS; group++)
+    {
+        if (routing_GetPosition(group, knownMask, activeMask, &positions[group]) != LE_OK)
+        {
+            positions[group] = -1;
+            result = LE_UNAVAILABLE;
+        }
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Register a StateChange handler for the client of the message being handled.
+ */
+//--------------------------------------------------------------------------------------------------
+mangoh_muxCtrl_StateChangeHandlerRef_t muxState_AddHandler
+(
+    mangoh_muxCtrl_StateChangeHandlerFunc_t handlerPtr,  ///< Handler to call
+    void* contextPtr                                     ///< Passed to the handler
+)
+{
+    return (mangoh_muxCtrl_StateChangeHandlerRef_t)sessionHandlers_Add(&Handlers, handlerPtr,
+                                                                       contextPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove a StateChange handler.
+ */
+//--------------------------------------------------------------------------------------------------
+void muxState_RemoveHandler
+(
+    mangoh_muxCtrl_StateChangeHandlerRef_t handlerRef  ///< Handler to remove
+)
+{
+    sessionHandlers_Remove(&Handlers, (le_event_HandlerRef_t)handlerRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove the StateChange handlers of a client session that has closed.
+ */
+//--------------------------------------------------------------------------------------------------
+void muxState_SessionClosed
+(
+    le_msg_SessionRef_t sessionRef
+)
+{
+    sessionHandlers_RemoveSession(&Handlers, sessionRef);
+}
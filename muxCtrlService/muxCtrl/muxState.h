@@ -0,0 +1,110 @@
+/**
+ * @file muxState.h
+ *
+ * Position of each mux and reset line, worked out from the pin state cache, and the StateChange
+ * event that reports changes to it.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#ifndef MUXCTRL_MUXSTATE_H_INCLUDE_GUARD
+#define MUXCTRL_MUXSTATE_H_INCLUDE_GUARD
+
+#include "pinState.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of mux groups.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MUX_STATE_NUM_GROUPS (MANGOH_MUXCTRL_MUX_RESET_ARDUINO + 1)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Recover the pin states left by a previous instance of the service from the shared-memory state
+ * page, which outlives the service.  Must be called before muxState_Init().
+ *
+ * The page is published after each write completes, so it can be one transition behind the pins;
+ * pinState_Init() only uses it for the pins it can't read back.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_NOT_FOUND if there is no page, i.e. this is the first start since boot
+ *      - LE_FAULT if the page could not be read
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t muxState_Recover
+(
+    pinState_Transition_t* transitionPtr  ///< Transition to add the recovered pin states to
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Create the StateChange event and record the current positions.  Must be called after the pins
+ * have been configured.
+ */
+//--------------------------------------------------------------------------------------------------
+void muxState_Init
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compare the current positions with the last reported ones and report each group that has
+ * changed.  Called on the main thread after each transition is committed.
+ */
+//--------------------------------------------------------------------------------------------------
+void muxState_Update
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the current position of every group from one snapshot of the pin state cache.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_UNAVAILABLE if the position of at least one group is not known; its entry is set to -1
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t muxState_GetPositions
+(
+    int32_t positions[MUX_STATE_NUM_GROUPS]  ///< [OUT] Position of each group
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Register a StateChange handler for the client of the message being handled.
+ */
+//--------------------------------------------------------------------------------------------------
+mangoh_muxCtrl_StateChangeHandlerRef_t muxState_AddHandler
+(
+    mangoh_muxCtrl_StateChangeHandlerFunc_t handlerPtr,  ///< Handler to call
+    void* contextPtr                                     ///< Passed to the handler
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove a StateChange handler.
+ */
+//--------------------------------------------------------------------------------------------------
+void muxState_RemoveHandler
+(
+    mangoh_muxCtrl_StateChangeHandlerRef_t handlerRef  ///< Handler to remove
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove the StateChange handlers of a client session that has closed.
+ */
+//--------------------------------------------------------------------------------------------------
+void muxState_SessionClosed
+(
+    le_msg_SessionRef_t sessionRef
+);
+
+#endif // MUXCTRL_MUXSTATE_H_INCLUDE_GUARD
@@ -0,0 +1,581 @@
+/**
+ * @file pinState.c
+ *
+ * Shadow copy of the GPIO expander pins driven by the mux control service, and the transition
+ * engine that writes changes to the expanders one expander at a time.
+ *
+ * Transitions are committed on the worker thread, while the main thread reads the shadow copy and
+ * the counters, so both are protected by a mutex.  The mutex is not held while the backend is
+ * writing to an expander.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "pinState.h"
+#include "backend.h"
+#include "stats.h"
+#include "trace.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * A table that describes each of the pins.  The expander locations match the bindings in
+ * muxCtrlService.adef.
+ */
+//--------------------------------------------------------------------------------------------------
+static const struct
+{
+    const char* name;
+    uint8_t expander;
+    uint8_t expanderPin;
+    bool activeLow;
+    bool initialValue;
+} Pins[PIN_COUNT] =
+{
+    [PIN_UART1_ENABLE]      = { "Uart1Enable",     1, 10, true,  false },
+    [PIN_UART1_SELECT]      = { "Uart1Select",     1, 11, false, false },
+    [PIN_SPI_ENABLE]        = { "SpiEnable",       1, 14, true,  false },
+    [PIN_SPI_SELECT]        = { "SpiSelect",       1, 15, false, false },
+    [PIN_UART2_ENABLE]      = { "Uart2Enable",     3,  8, true,  true  },
+    [PIN_UART2_SELECT]      = { "Uart2Select",     1, 12, false, false },
+    [PIN_PCM_ENABLE]        = { "PcmEnable",       3,  9, true,  false },
+    [PIN_PCM_SELECT]        = { "PcmSelect",       3, 10, false, false },
+    [PIN_SDIO_SELECT]       = { "SdioSelect",      1, 13, false, true  },
+    [PIN_PCM_ANALOG_SELECT] = { "PcmAnalogSelect", 1,  6, false, false },
+    [PIN_IOT0_RESET]        = { "Iot0Reset",       3,  4, true,  true  },
+    [PIN_IOT1_RESET]        = { "Iot1Reset",       3,  3, true,  true  },
+    [PIN_IOT2_RESET]        = { "Iot2Reset",       3,  2, true,  true  },
+    [PIN_ARDUINO_RESET]     = { "ArduinoReset",    1,  4, true,  true  },
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The last state written to each pin.  A pin whose state is not known (because it has never been
+ * written successfully, a write failed or the cache was invalidated) is always written.
+ */
+//--------------------------------------------------------------------------------------------------
+static struct
+{
+    bool known;
+    bool active;
+} Shadow[PIN_COUNT];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Backend used to drive the expanders.
+ */
+//--------------------------------------------------------------------------------------------------
+static const backend_Ops_t* BackendPtr;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Shadow copy hit/miss counters and the number of expander writes.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t CacheHits;
+static uint32_t CacheMisses;
+static uint32_t ExpanderWrites;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Protects Shadow and the counters.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mutex_Ref_t Mutex;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write a group of pins of a transition on one expander and update the shadow copy to match.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t WriteGroup
+(
+    uint8_t expander,
+    uint32_t pinMask,
+    const pinState_Transition_t* transitionPtr
+)
+{
+    uint32_t pinValues = transitionPtr->values;
+    pinState_Pin_t order[PIN_COUNT];
+    int numPins = 0;
+
+    // List the pins in the order they were added to the transition.
+    for (int pin = 0; pin < PIN_COUNT; pin++)
+    {
+        if (pinMask & (1 << pin))
+        {
+            const uint32_t* touchPtr = transitionPtr->pinTouch;
+            int i = numPins++;
+            while ((i > 0) && (touchPtr[order[i - 1]] > touchPtr[pin]))
+            {
+                order[i] = order[i - 1];
+                i--;
+            }
+            order[i] = pin;
+        }
+    }
+
+    uint64_t startTime = stats_GetTimeStamp();
+    le_result_t result = BackendPtr->write(expander, pinMask, pinValues & pinMask, order);
+    stats_RecordGpioCall(pinMask, result, startTime);
+
+    le_mutex_Lock(Mutex);
+    ExpanderWrites++;
+    for (int i = 0; i < numPins; i++)
+    {
+        pinState_Pin_t pin = order[i];
+
+        trace_Record(startTime, transitionPtr->traceClient, transitionPtr->traceCall,
+                     pin, (pinValues & (1 << pin)) != 0, result);
+
+        // If the write failed, the state of the pin can't be trusted any more.
+        Shadow[pin].known = (result == LE_OK);
+        Shadow[pin].active = ((pinValues & (1 << pin)) != 0);
+    }
+    le_mutex_Unlock(Mutex);
+
+    return (result == LE_OK) ? LE_OK : LE_FAULT;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether the shadow copy says that a pin of a transition is already in the requested
+ * state.  Must be called with the mutex held.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsPinUnchanged
+(
+    const pinState_Transition_t* transitionPtr,
+    pinState_Pin_t pin
+)
+{
+    bool active = ((transitionPtr->values & (1 << pin)) != 0);
+
+    return !transitionPtr->force && Shadow[pin].known && (Shadow[pin].active == active);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether a pin is configured before another at start-up.  Select pins go before the
+ * enables and resets (the active-low pins), so that no peripheral is connected or let out of reset
+ * while its mux still points somewhere else; otherwise pins go in the order they were added to the
+ * start transition, after the pins that are not in it.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool ConfiguresBefore
+(
+    const pinState_Transition_t* startPtr,
+    pinState_Pin_t pin,
+    pinState_Pin_t otherPin
+)
+{
+    if (Pins[pin].activeLow != Pins[otherPin].activeLow)
+    {
+        return !Pins[pin].activeLow;
+    }
+
+    if (startPtr == NULL)
+    {
+        return false;
+    }
+
+    uint32_t touch = (startPtr->mask & (1 << pin)) ? startPtr->pinTouch[pin] : 0;
+    uint32_t otherTouch = (startPtr->mask & (1 << otherPin)) ? startPtr->pinTouch[otherPin] : 0;
+
+    return touch < otherTouch;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Select and initialize the backend, bring every pin to its start state as a push-pull output and
+ * seed the shadow copy with those states.  Must be called on the thread that commits transitions.
+ *
+ * On a cold start, the start state of a pin is the one given in startPtr if the pin is in it;
+ * otherwise it is the state the pin is read back in, if the backend can read it; otherwise it is
+ * the pin's default.
+ *
+ * On a warm start the pins were left by a previous instance of the service, which may have died
+ * after writing a pin but before recording it anywhere.  So a pin that the backend can read back
+ * keeps the state it reads back in, and startPtr only applies to the pins that can't be read.
+ *
+ * A pin that reads back in its start state is left alone, so that a restart of the service does
+ * not disturb the peripherals.  The other pins are configured selects first, then enables and
+ * resets, each in the order they were added to startPtr.
+ */
+//--------------------------------------------------------------------------------------------------
+void pinState_Init
+(
+    const pinState_Transition_t* startPtr, ///< Start states of some pins, or NULL for none
+    bool warmStart                         ///< true if the service is restarting
+)
+{
+    int keptCount = 0;
+
+    Mutex = le_mutex_CreateNonRecursive("Pin state");
+
+    BackendPtr = backend_Select();
+    LE_INFO("Using the '%s' backend", BackendPtr->name);
+
+    if ((BackendPtr->init != NULL) && (BackendPtr->init() != LE_OK))
+    {
+        LE_FATAL("Failed to initialize the '%s' backend", BackendPtr->name);
+    }
+
+    pinState_Pin_t order[PIN_COUNT];
+    for (int pin = 0; pin < PIN_COUNT; pin++)
+    {
+        int i = pin;
+        while ((i > 0) && ConfiguresBefore(startPtr, pin, order[i - 1]))
+        {
+            order[i] = order[i - 1];
+            i--;
+        }
+        order[i] = pin;
+    }
+
+    for (int i = 0; i < PIN_COUNT; i++)
+    {
+        pinState_Pin_t pin = order[i];
+        bool current;
+        bool haveCurrent = (BackendPtr->read != NULL) &&
+                           (BackendPtr->read(pin, &current) == LE_OK);
+
+        bool active = Pins[pin].initialValue;
+        if (haveCurrent && warmStart)
+        {
+            active = current;
+        }
+        else if ((startPtr != NULL) && (startPtr->mask & (1 << pin)))
+        {
+            active = ((startPtr->values & (1 << pin)) != 0);
+        }
+        else if (haveCurrent)
+        {
+            active = current;
+        }
+
+        Shadow[pin].active = active;
+        if (haveCurrent && (current == active))
+        {
+            Shadow[pin].known = true;
+            keptCount++;
+            continue;
+        }
+
+        uint64_t startTime = stats_GetTimeStamp();
+        le_result_t result = BackendPtr->configure(pin, active);
+        stats_RecordGpioCall(1 << pin, result, startTime);
+        trace_Record(startTime, 0, PIN_STATE_NO_CALL, pin, active, result);
+
+        Shadow[pin].known = (result == LE_OK);
+        if (!Shadow[pin].known)
+        {
+            LE_ERROR("Failed to configure pin %s as an output", Pins[pin].name);
+        }
+    }
+
+    LE_INFO("%d of %d pins were already in their start state", keptCount, PIN_COUNT);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start a new, empty transition.
+ */
+//--------------------------------------------------------------------------------------------------
+void pinState_StartTransition
+(
+    pinState_Transition_t* transitionPtr,  ///< Transition to initialize
+    bool force                             ///< true to write pins even if they are unchanged
+)
+{
+    memset(transitionPtr, 0, sizeof(*transitionPtr));
+    transitionPtr->force = force;
+    transitionPtr->traceCall = PIN_STATE_NO_CALL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a pin change to a transition.  If the pin is already part of the transition, the new value
+ * replaces the old one.
+ */
+//--------------------------------------------------------------------------------------------------
+void pinState_AddPin
+(
+    pinState_Transition_t* transitionPtr,  ///< Transition to add to
+    pinState_Pin_t pin,                    ///< Pin to set
+    bool active                            ///< true to activate the pin, false to deactivate it
+)
+{
+    LE_ASSERT(pin < PIN_COUNT);
+
+    transitionPtr->mask |= (1 << pin);
+    if (active)
+    {
+        transitionPtr->values |= (1 << pin);
+    }
+    else
+    {
+        transitionPtr->values &= ~(1 << pin);
+    }
+
+    transitionPtr->touchCount++;
+    transitionPtr->lastTouch[Pins[pin].expander] = transitionPtr->touchCount;
+    transitionPtr->pinTouch[pin] = transitionPtr->touchCount;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write the pins of a transition that differ from the shadow copy, with one write per expander.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_FAULT if an expander write failed.  Expanders after the failed one are not written.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pinState_CommitTransition
+(
+    pinState_Transition_t* transitionPtr  ///< Transition to commit
+)
+{
+    uint32_t groupMask[PIN_STATE_MAX_EXPANDER + 1] = { 0 };
+
+    le_mutex_Lock(Mutex);
+    for (int pin = 0; pin < PIN_COUNT; pin++)
+    {
+        if ((transitionPtr->mask & (1 << pin)) == 0)
+        {
+            continue;
+        }
+
+        if (IsPinUnchanged(transitionPtr, pin))
+        {
+            CacheHits++;
+        }
+        else
+        {
+            CacheMisses++;
+            groupMask[Pins[pin].expander] |= (1 << pin);
+        }
+    }
+    le_mutex_Unlock(Mutex);
+
+    for (;;)
+    {
+        // Pick the pending expander that was touched least recently.
+        uint8_t next = 0;
+        for (uint8_t expander = 1; expander <= PIN_STATE_MAX_EXPANDER; expander++)
+        {
+            if ((groupMask[expander] != 0) &&
+                ((next == 0) ||
+                 (transitionPtr->lastTouch[expander] < transitionPtr->lastTouch[next])))
+            {
+                next = expander;
+            }
+        }
+
+        if (next == 0)
+        {
+            return LE_OK;
+        }
+
+        if (WriteGroup(next, groupMask[next], transitionPtr) != LE_OK)
+        {
+            return LE_FAULT;
+        }
+        groupMask[next] = 0;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether committing a transition would write nothing, because every pin in it is already
+ * in the requested state.
+ */
+//--------------------------------------------------------------------------------------------------
+bool pinState_IsUnchanged
+(
+    const pinState_Transition_t* transitionPtr  ///< Transition to check
+)
+{
+    bool unchanged = true;
+
+    le_mutex_Lock(Mutex);
+    for (int pin = 0; (pin < PIN_COUNT) && unchanged; pin++)
+    {
+        if (transitionPtr->mask & (1 << pin))
+        {
+            unchanged = IsPinUnchanged(transitionPtr, pin);
+        }
+    }
+    le_mutex_Unlock(Mutex);
+
+    return unchanged;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Mark every pin in the shadow copy as unknown, so that the next write to each pin reaches the
+ * expander.
+ */
+//--------------------------------------------------------------------------------------------------
+void pinState_Invalidate
+(
+    void
+)
+{
+    le_mutex_Lock(Mutex);
+    for (int pin = 0; pin < PIN_COUNT; pin++)
+    {
+        Shadow[pin].known = false;
+    }
+    le_mutex_Unlock(Mutex);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a consistent copy of the shadow state of all pins, as bit masks indexed by pinState_Pin_t.
+ */
+//--------------------------------------------------------------------------------------------------
+void pinState_GetSnapshot
+(
+    uint32_t* knownMaskPtr,   ///< [OUT] Pins whose state is known
+    uint32_t* activeMaskPtr   ///< [OUT] Pins that are active (only meaningful if known)
+)
+{
+    uint32_t known = 0;
+    uint32_t active = 0;
+
+    le_mutex_Lock(Mutex);
+    for (int pin = 0; pin < PIN_COUNT; pin++)
+    {
+        if (Shadow[pin].known)
+        {
+            known |= (1 << pin);
+        }
+        if (Shadow[pin].active)
+        {
+            active |= (1 << pin);
+        }
+    }
+    le_mutex_Unlock(Mutex);
+
+    *knownMaskPtr = known;
+    *activeMaskPtr = active;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of pin writes suppressed by (hits) and passed through (misses) the shadow copy.
+ */
+//--------------------------------------------------------------------------------------------------
+void pinState_GetCacheStats
+(
+    uint32_t* hitsPtr,   ///< [OUT] Number of writes that were skipped
+    uint32_t* missesPtr  ///< [OUT] Number of writes that were sent to the expander
+)
+{
+    le_mutex_Lock(Mutex);
+    *hitsPtr = CacheHits;
+    *missesPtr = CacheMisses;
+    le_mutex_Unlock(Mutex);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of writes made to the expanders.  A write may set several pins.
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t pinState_GetWriteCount
+(
+    void
+)
+{
+    le_mutex_Lock(Mutex);
+    uint32_t writes = ExpanderWrites;
+    le_mutex_Unlock(Mutex);
+
+    return writes;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of bus transactions the backend has made to the expanders.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_UNSUPPORTED if the backend does not count its bus transactions
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pinState_GetBusTransactionCount
+(
+    uint32_t* countPtr  ///< [OUT] Number of bus transactions
+)
+{
+    if (BackendPtr->getTransactionCount == NULL)
+    {
+        return LE_UNSUPPORTED;
+    }
+
+    *countPtr = BackendPtr->getTransactionCount();
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the name of a pin.
+ */
+//--------------------------------------------------------------------------------------------------
+const char* pinState_GetName
+(
+    pinState_Pin_t pin
+)
+{
+    return Pins[pin].name;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of the expander that a pin is on.
+ */
+//--------------------------------------------------------------------------------------------------
+uint8_t pinState_GetExpander
+(
+    pinState_Pin_t pin
+)
+{
+    return Pins[pin].expander;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of a pin on its expander.
+ */
+//--------------------------------------------------------------------------------------------------
+uint8_t pinState_GetExpanderPin
+(
+    pinState_Pin_t pin
+)
+{
+    return Pins[pin].expanderPin;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether a pin is active-low (driven low when it is active).
+ */
+//--------------------------------------------------------------------------------------------------
+bool pinState_IsActiveLow
+(
+    pinState_Pin_t pin
+)
+{
+    return Pins[pin].activeLow;
+}
@@ -0,0 +1,251 @@
+/**
+ * @file pinState.h
+ *
+ * Shadow copy of the GPIO expander pins driven by the mux control service.
+ *
+ * Every pin write goes through this module so that writes which would not change the state of the
+ * pin can be suppressed without issuing an IPC call (and I2C transaction) to the GPIO expander
+ * service.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#ifndef MUXCTRL_PIN_STATE_H_INCLUDE_GUARD
+#define MUXCTRL_PIN_STATE_H_INCLUDE_GUARD
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Expander pins controlled by the mux control service.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    PIN_UART1_ENABLE,
+    PIN_UART1_SELECT,
+    PIN_SPI_ENABLE,
+    PIN_SPI_SELECT,
+    PIN_UART2_ENABLE,
+    PIN_UART2_SELECT,
+    PIN_PCM_ENABLE,
+    PIN_PCM_SELECT,
+    PIN_SDIO_SELECT,
+    PIN_PCM_ANALOG_SELECT,
+    PIN_IOT0_RESET,
+    PIN_IOT1_RESET,
+    PIN_IOT2_RESET,
+    PIN_ARDUINO_RESET,
+    PIN_COUNT
+}
+pinState_Pin_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Highest expander number.  Expanders are numbered as in the mangoh_gpioExp<n>Pin<m> interfaces
+ * of gpioExpanderServiceGreen.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PIN_STATE_MAX_EXPANDER 3
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * traceCall of a transition that was not made for an API call.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PIN_STATE_NO_CALL UINT32_MAX
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * A set of pin changes that are made together.  The changes are grouped by expander and each
+ * group is written to its expander at once.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint32_t mask;                                  ///< Pins to set (bit n is pinState_Pin_t n)
+    uint32_t values;                                ///< Requested values of the pins in mask
+    uint32_t lastTouch[PIN_STATE_MAX_EXPANDER + 1]; ///< When each expander was last added to
+    uint32_t pinTouch[PIN_COUNT];                   ///< When each pin was last added
+    uint32_t touchCount;                            ///< Number of pins added so far
+    bool force;                                     ///< Write pins even if they are unchanged
+    int32_t traceClient;                            ///< Client process traced with the writes
+    uint32_t traceCall;                             ///< API call traced with the writes
+}
+pinState_Transition_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Select and initialize the backend, bring every pin to its start state as a push-pull output and
+ * seed the shadow copy with those states.  Must be called on the thread that commits transitions.
+ *
+ * On a cold start, the start state of a pin is the one given in startPtr if the pin is in it;
+ * otherwise it is the state the pin is read back in, if the backend can read it; otherwise it is
+ * the pin's default.
+ *
+ * On a warm start the pins were left by a previous instance of the service, which may have died
+ * after writing a pin but before recording it anywhere.  So a pin that the backend can read back
+ * keeps the state it reads back in, and startPtr only applies to the pins that can't be read.
+ *
+ * A pin that reads back in its start state is left alone, so that a restart of the service does
+ * not disturb the peripherals.  The other pins are configured selects first, then enables and
+ * resets, each in the order they were added to startPtr.
+ */
+//--------------------------------------------------------------------------------------------------
+void pinState_Init
+(
+    const pinState_Transition_t* startPtr, ///< Start states of some pins, or NULL for none
+    bool warmStart                         ///< true if the service is restarting
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start a new, empty transition.
+ */
+//--------------------------------------------------------------------------------------------------
+void pinState_StartTransition
+(
+    pinState_Transition_t* transitionPtr,  ///< Transition to initialize
+    bool force                             ///< true to write pins even if they are unchanged
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a pin change to a transition.  If the pin is already part of the transition, the new value
+ * replaces the old one.
+ */
+//--------------------------------------------------------------------------------------------------
+void pinState_AddPin
+(
+    pinState_Transition_t* transitionPtr,  ///< Transition to add to
+    pinState_Pin_t pin,                    ///< Pin to set
+    bool active                            ///< true to activate the pin, false to deactivate it
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write the pins of a transition that differ from the shadow copy, with one write per expander.
+ *
+ * Expanders are written in the order in which they were last added to the transition, and a
+ * backend that writes an expander's pins one at a time writes them in the order they were added,
+ * so the last pin added (usually an enable) changes no earlier than any other pin.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_FAULT if an expander write failed.  Expanders after the failed one are not written.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pinState_CommitTransition
+(
+    pinState_Transition_t* transitionPtr  ///< Transition to commit
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether committing a transition would write nothing, because every pin in it is already
+ * in the requested state.
+ */
+//--------------------------------------------------------------------------------------------------
+bool pinState_IsUnchanged
+(
+    const pinState_Transition_t* transitionPtr  ///< Transition to check
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Mark every pin in the shadow copy as unknown, so that the next write to each pin reaches the
+ * expander.
+ */
+//--------------------------------------------------------------------------------------------------
+void pinState_Invalidate
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a consistent copy of the shadow state of all pins, as bit masks indexed by pinState_Pin_t.
+ */
+//--------------------------------------------------------------------------------------------------
+void pinState_GetSnapshot
+(
+    uint32_t* knownMaskPtr,   ///< [OUT] Pins whose state is known
+    uint32_t* activeMaskPtr   ///< [OUT] Pins that are active (only meaningful if known)
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of pin writes suppressed by (hits) and passed through (misses) the shadow copy.
+ */
+//--------------------------------------------------------------------------------------------------
+void pinState_GetCacheStats
+(
+    uint32_t* hitsPtr,   ///< [OUT] Number of writes that were skipped
+    uint32_t* missesPtr  ///< [OUT] Number of writes that were sent to the expander
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of writes made to the expanders.  A write may set several pins.
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t pinState_GetWriteCount
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of bus transactions the backend has made to the expanders.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_UNSUPPORTED if the backend does not count its bus transactions
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pinState_GetBusTransactionCount
+(
+    uint32_t* countPtr  ///< [OUT] Number of bus transactions
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the name of a pin.
+ */
+//--------------------------------------------------------------------------------------------------
+const char* pinState_GetName
+(
+    pinState_Pin_t pin
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of the expander that a pin is on.
+ */
+//--------------------------------------------------------------------------------------------------
+uint8_t pinState_GetExpander
+(
+    pinState_Pin_t pin
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of a pin on its expander.
+ */
+//--------------------------------------------------------------------------------------------------
+uint8_t pinState_GetExpanderPin
+(
+    pinState_Pin_t pin
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether a pin is active-low (driven low when it is active).
+ */
+//--------------------------------------------------------------------------------------------------
+bool pinState_IsActiveLow
+(
+    pinState_Pin_t pin
+);
+
+#endif // MUXCTRL_PIN_STATE_H_INCLUDE_GUARD
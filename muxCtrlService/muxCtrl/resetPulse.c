@@ -0,0 +1,328 @@
+/**
+ * @file resetPulse.c
+ *
+ * Reset pulses timed with Legato timers, so that the service's event loop keeps running while a
+ * target is held in reset.  The reset pin is written through the worker thread, and the timer
+ * only starts once the target is actually in reset.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "pinState.h"
+#include "worker.h"
+#include "routing.h"
+#include "resetPulse.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of reset targets.
+ */
+//--------------------------------------------------------------------------------------------------
+#define NUM_TARGETS (MANGOH_MUXCTRL_RESET_ARDUINO + 1)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Someone waiting for a reset pulse to complete.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_sls_Link_t link;
+    resetPulse_DoneFunc_t assertedFunc;     ///< Still to be told that the target is in reset
+    resetPulse_DoneFunc_t doneFunc;
+    void* contextPtr;
+}
+Waiter_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * State of the reset pulse of each target.
+ */
+//--------------------------------------------------------------------------------------------------
+static struct
+{
+    le_timer_Ref_t timer;      ///< Timer that ends the pulse
+    uint32_t widthUs;          ///< Pulse width in microseconds
+    le_sls_List_t waiters;     ///< Waiter_t for everyone waiting for the current pulse to end
+    bool asserted;             ///< true once the current pulse has put the target in reset
+    int32_t traceClient;       ///< Client that started the current pulse, for the trace
+    uint32_t traceCall;        ///< API call that started the current pulse, for the trace
+} Targets[NUM_TARGETS];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pool of Waiter_t.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t WaiterPool;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tell everyone waiting for the pulse of a target that it is complete.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CompletePulse
+(
+    mangoh_muxCtrl_ResetTarget_t target,
+    le_result_t result
+)
+{
+    // Take the waiters off the target first, so that one that starts another pulse of the target
+    // starts a new pulse rather than joining this one.
+    le_sls_List_t waiters = Targets[target].waiters;
+    le_sls_Link_t* linkPtr;
+
+    Targets[target].waiters = LE_SLS_LIST_INIT;
+    Targets[target].asserted = false;
+    while ((linkPtr = le_sls_Pop(&waiters)) != NULL)
+    {
+        Waiter_t* waiterPtr = CONTAINER_OF(linkPtr, Waiter_t, link);
+        waiterPtr->doneFunc(result, waiterPtr->contextPtr);
+        le_mem_Release(waiterPtr);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write the reset pin of a target through the worker thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SetResetPin
+(
+    mangoh_muxCtrl_ResetTarget_t target,
+    bool asserted,
+    worker_DoneFunc_t doneFunc
+)
+{
+    pinState_Transition_t transition;
+
+    pinState_StartTransition(&transition, false);
+    transition.traceClient = Targets[target].traceClient;
+    transition.traceCall = Targets[target].traceCall;
+    routing_AddReset(&transition, target, asserted);
+    worker_Commit(&transition, doneFunc, (void*)(intptr_t)target);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Called when a target has been taken out of reset at the end of its pulse.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ResetDeasserted
+(
+    le_result_t result,
+    void* contextPtr
+)
+{
+    mangoh_muxCtrl_ResetTarget_t target = (intptr_t)contextPtr;
+
+    if (result != LE_OK)
+    {
+        LE_ERROR("Failed to take %s out of reset",
+                 pinState_GetName(routing_GetResetPin(target)));
+    }
+
+    CompletePulse(target, result);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Take a target out of reset at the end of its pulse.
+ */
+//--------------------------------------------------------------------------------------------------
+static void PulseTimerExpired
+(
+    le_timer_Ref_t timer
+)
+{
+    SetResetPin((intptr_t)le_timer_GetContextPtr(timer), false, ResetDeasserted);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Called when a target has been put in reset.  Starts the timer that ends the pulse.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ResetAsserted
+(
+    le_result_t result,
+    void* contextPtr
+)
+{
+    mangoh_muxCtrl_ResetTarget_t target = (intptr_t)contextPtr;
+
+    if (result != LE_OK)
+    {
+        LE_ERROR("Failed to put %s in reset", pinState_GetName(routing_GetResetPin(target)));
+        CompletePulse(target, LE_FAULT);
+        return;
+    }
+
+    le_clk_Time_t width =
+    {
+        .sec = Targets[target].widthUs / 1000000,
+        .usec = Targets[target].widthUs % 1000000
+    };
+    le_timer_SetInterval(Targets[target].timer, width);
+    le_timer_Start(Targets[target].timer);
+
+    Targets[target].asserted = true;
+    for (le_sls_Link_t* linkPtr = le_sls_Peek(&Targets[target].waiters);
+         linkPtr != NULL;
+         linkPtr = le_sls_PeekNext(&Targets[target].waiters, linkPtr))
+    {
+        Waiter_t* waiterPtr = CONTAINER_OF(linkPtr, Waiter_t, link);
+        resetPulse_DoneFunc_t assertedFunc = waiterPtr->assertedFunc;
+        if (assertedFunc != NULL)
+        {
+            waiterPtr->assertedFunc = NULL;
+            assertedFunc(LE_OK, waiterPtr->contextPtr);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the reset pulse timers.
+ */
+//--------------------------------------------------------------------------------------------------
+void resetPulse_Init
+(
+    void
+)
+{
+    WaiterPool = le_mem_CreatePool("Reset pulse waiters", sizeof(Waiter_t));
+
+    for (intptr_t target = 0; target < NUM_TARGETS; target++)
+    {
+        Targets[target].timer = le_timer_Create("Reset pulse");
+        le_timer_SetHandler(Targets[target].timer, PulseTimerExpired);
+        le_timer_SetContextPtr(Targets[target].timer, (void*)target);
+        Targets[target].widthUs = RESET_PULSE_DEFAULT_WIDTH_US;
+        Targets[target].waiters = LE_SLS_LIST_INIT;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the width of the reset pulses of a target.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_BAD_PARAMETER if the target is not valid
+ *      - LE_OUT_OF_RANGE if the width is 0 or more than RESET_PULSE_MAX_WIDTH_US
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t resetPulse_SetWidth
+(
+    mangoh_muxCtrl_ResetTarget_t target,  ///< Reset target
+    uint32_t widthUs                      ///< Pulse width in microseconds
+)
+{
+    if ((target < 0) || (target >= NUM_TARGETS))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    if ((widthUs == 0) || (widthUs > RESET_PULSE_MAX_WIDTH_US))
+    {
+        return LE_OUT_OF_RANGE;
+    }
+
+    Targets[target].widthUs = widthUs;
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether a reset pulse is in progress for a target.
+ */
+//--------------------------------------------------------------------------------------------------
+bool resetPulse_IsInProgress
+(
+    mangoh_muxCtrl_ResetTarget_t target  ///< Reset target
+)
+{
+    // A pulse is in progress for as long as someone is waiting for it.
+    return (target >= 0) && (target < NUM_TARGETS) && !le_sls_IsEmpty(&Targets[target].waiters);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Put a target in reset and take it out of reset again when its pulse width has elapsed.  If a
+ * pulse is already in progress for the target, the caller is instead told when that pulse ends.
+ */
+//--------------------------------------------------------------------------------------------------
+void resetPulse_Start
+(
+    mangoh_muxCtrl_ResetTarget_t target,  ///< Reset target
+    int32_t traceClient,                  ///< Client process starting the pulse, for the trace
+    uint32_t traceCall,                   ///< API call starting the pulse, for the trace
+    resetPulse_DoneFunc_t assertedFunc,   ///< Function to call once the target is in reset, or NULL
+    resetPulse_DoneFunc_t doneFunc,       ///< Function to call when the pulse is complete
+    void* contextPtr                      ///< Passed to assertedFunc and doneFunc
+)
+{
+    if ((target < 0) || (target >= NUM_TARGETS))
+    {
+        LE_ERROR("Invalid reset target (%d)", target);
+        doneFunc(LE_BAD_PARAMETER, contextPtr);
+        return;
+    }
+
+    bool inProgress = resetPulse_IsInProgress(target);
+
+    Waiter_t* waiterPtr = le_mem_ForceAlloc(WaiterPool);
+    waiterPtr->link = LE_SLS_LINK_INIT;
+    waiterPtr->assertedFunc = Targets[target].asserted ? NULL : assertedFunc;
+    waiterPtr->doneFunc = doneFunc;
+    waiterPtr->contextPtr = contextPtr;
+    le_sls_Queue(&Targets[target].waiters, &waiterPtr->link);
+
+    if (!inProgress)
+    {
+        Targets[target].traceClient = traceClient;
+        Targets[target].traceCall = traceCall;
+        SetResetPin(target, true, ResetAsserted);
+    }
+    else if (Targets[target].asserted && (assertedFunc != NULL))
+    {
+        assertedFunc(LE_OK, contextPtr);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for the reset pulse in progress for a target to end, without starting one.  doneFunc is
+ * called straight away if no pulse is in progress.
+ */
+//--------------------------------------------------------------------------------------------------
+void resetPulse_WaitForEnd
+(
+    mangoh_muxCtrl_ResetTarget_t target,  ///< Reset target
+    resetPulse_DoneFunc_t doneFunc,       ///< Function to call when the pulse is complete
+    void* contextPtr                      ///< Passed to doneFunc
+)
+{
+    if (!resetPulse_IsInProgress(target))
+    {
+        doneFunc(LE_OK, contextPtr);
+        return;
+    }
+
+    Waiter_t* waiterPtr = le_mem_ForceAlloc(WaiterPool);
+    waiterPtr->link = LE_SLS_LINK_INIT;
+    waiterPtr->assertedFunc = NULL;
+    waiterPtr->doneFunc = doneFunc;
+    waiterPtr->contextPtr = contextPtr;
+    le_sls_Queue(&Targets[target].waiters, &waiterPtr->link);
+}
@@ -0,0 +1,111 @@
+/**
+ * @file resetPulse.h
+ *
+ * Reset pulses timed with Legato timers, so that the service's event loop keeps running while a
+ * target is held in reset.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#ifndef MUXCTRL_RESET_PULSE_H_INCLUDE_GUARD
+#define MUXCTRL_RESET_PULSE_H_INCLUDE_GUARD
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default width of a reset pulse, in microseconds.
+ */
+//--------------------------------------------------------------------------------------------------
+#define RESET_PULSE_DEFAULT_WIDTH_US 300
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Longest reset pulse that can be requested, in microseconds.
+ */
+//--------------------------------------------------------------------------------------------------
+#define RESET_PULSE_MAX_WIDTH_US 10000000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Function called when a reset pulse has completed.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*resetPulse_DoneFunc_t)
+(
+    le_result_t result,  ///< LE_OK if the target was put in and taken out of reset, else LE_FAULT
+    void* contextPtr     ///< Context pointer passed to resetPulse_Start()
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the reset pulse timers.
+ */
+//--------------------------------------------------------------------------------------------------
+void resetPulse_Init
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the width of the reset pulses of a target.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_BAD_PARAMETER if the target is not valid
+ *      - LE_OUT_OF_RANGE if the width is 0 or more than RESET_PULSE_MAX_WIDTH_US
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t resetPulse_SetWidth
+(
+    mangoh_muxCtrl_ResetTarget_t target,  ///< Reset target
+    uint32_t widthUs                      ///< Pulse width in microseconds
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether a reset pulse is in progress for a target.
+ */
+//--------------------------------------------------------------------------------------------------
+bool resetPulse_IsInProgress
+(
+    mangoh_muxCtrl_ResetTarget_t target  ///< Reset target
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Put a target in reset and take it out of reset again when its pulse width has elapsed.  If a
+ * pulse is already in progress for the target, the caller is instead told when that pulse ends.
+ *
+ * assertedFunc, if not NULL, is called once the target is in reset, or straight away if it already
+ * is.  It is not called if the target could not be put in reset.
+ *
+ * doneFunc is always called, after assertedFunc, and possibly before this function returns if the
+ * pulse could not be started.
+ */
+//--------------------------------------------------------------------------------------------------
+void resetPulse_Start
+(
+    mangoh_muxCtrl_ResetTarget_t target,  ///< Reset target
+    int32_t traceClient,                  ///< Client process starting the pulse, for the trace
+    uint32_t traceCall,                   ///< API call starting the pulse, for the trace
+    resetPulse_DoneFunc_t assertedFunc,   ///< Function to call once the target is in reset, or NULL
+    resetPulse_DoneFunc_t doneFunc,       ///< Function to call when the pulse is complete
+    void* contextPtr                      ///< Passed to assertedFunc and doneFunc
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for the reset pulse in progress for a target to end, without starting one.  doneFunc is
+ * called straight away if no pulse is in progress.
+ */
+//--------------------------------------------------------------------------------------------------
+void resetPulse_WaitForEnd
+(
+    mangoh_muxCtrl_ResetTarget_t target,  ///< Reset target
+    resetPulse_DoneFunc_t doneFunc,       ///< Function to call when the pulse is complete
+    void* contextPtr                      ///< Passed to doneFunc
+);
+
+#endif // MUXCTRL_RESET_PULSE_H_INCLUDE_GUARD
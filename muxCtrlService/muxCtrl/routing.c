@@ -0,0 +1,402 @@
+/**
+ * @file routing.c
+ *
+ * Translation of mux routings into the pin changes that select them.
+ *
+ * Select pins are always added before the enable pin of the same mux, so that a mux is never
+ * enabled towards the wrong destination.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "routing.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the pin changes that route UART 1 as requested to a transition.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_BAD_PARAMETER if the route is not valid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t routing_AddUart1
+(
+    pinState_Transition_t* transitionPtr,  ///< Transition to add to
+    mangoh_muxCtrl_Uart1Route_t route      ///< Requested route
+)
+{
+    switch (route)
+    {
+        case MANGOH_MUXCTRL_UART1_OFF:
+            pinState_AddPin(transitionPtr, PIN_UART1_ENABLE, false);
+            break;
+
+        case MANGOH_MUXCTRL_UART1_IOT0:
+            pinState_AddPin(transitionPtr, PIN_UART1_SELECT, true);
+            pinState_AddPin(transitionPtr, PIN_UART1_ENABLE, true);
+            break;
+
+        case MANGOH_MUXCTRL_UART1_IOT1:
+            pinState_AddPin(transitionPtr, PIN_UART1_SELECT, false);
+            pinState_AddPin(transitionPtr, PIN_UART1_ENABLE, true);
+            break;
+
+        default:
+            LE_ERROR("Invalid UART 1 route (%d)", route);
+            return LE_BAD_PARAMETER;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the pin changes that route SPI as requested to a transition.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_BAD_PARAMETER if the route is not valid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t routing_AddSpi
+(
+    pinState_Transition_t* transitionPtr,  ///< Transition to add to
+    mangoh_muxCtrl_SpiRoute_t route        ///< Requested route
+)
+{
+    switch (route)
+    {
+        case MANGOH_MUXCTRL_SPI_OFF:
+            pinState_AddPin(transitionPtr, PIN_SPI_ENABLE, false);
+            break;
+
+        case MANGOH_MUXCTRL_SPI_IOT0:
+            pinState_AddPin(transitionPtr, PIN_SPI_SELECT, true);
+            pinState_AddPin(transitionPtr, PIN_SPI_ENABLE, true);
+            break;
+
+        case MANGOH_MUXCTRL_SPI_IOT1:
+            pinState_AddPin(transitionPtr, PIN_SPI_SELECT, false);
+            pinState_AddPin(transitionPtr, PIN_SPI_ENABLE, true);
+            break;
+
+        default:
+            LE_ERROR("Invalid SPI route (%d)", route);
+            return LE_BAD_PARAMETER;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the pin changes that route UART 2 as requested to a transition.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_BAD_PARAMETER if the route is not valid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t routing_AddUart2
+(
+    pinState_Transition_t* transitionPtr,  ///< Transition to add to
+    mangoh_muxCtrl_Uart2Route_t route      ///< Requested route
+)
+{
+    switch (route)
+    {
+        case MANGOH_MUXCTRL_UART2_OFF:
+            pinState_AddPin(transitionPtr, PIN_UART2_ENABLE, false);
+            break;
+
+        case MANGOH_MUXCTRL_UART2_IOT2:
+            pinState_AddPin(transitionPtr, PIN_UART2_SELECT, true);
+            pinState_AddPin(transitionPtr, PIN_UART2_ENABLE, true);
+            break;
+
+        case MANGOH_MUXCTRL_UART2_DEBUG:
+            pinState_AddPin(transitionPtr, PIN_UART2_SELECT, false);
+            pinState_AddPin(transitionPtr, PIN_UART2_ENABLE, true);
+            break;
+
+        default:
+            LE_ERROR("Invalid UART 2 route (%d)", route);
+            return LE_BAD_PARAMETER;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the pin changes that route SDIO as requested to a transition.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_BAD_PARAMETER if the route is not valid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t routing_AddSdio
+(
+    pinState_Transition_t* transitionPtr,  ///< Transition to add to
+    mangoh_muxCtrl_SdioRoute_t route       ///< Requested route
+)
+{
+    switch (route)
+    {
+        case MANGOH_MUXCTRL_SDIO_MICROSD:
+            pinState_AddPin(transitionPtr, PIN_SDIO_SELECT, true);
+            break;
+
+        case MANGOH_MUXCTRL_SDIO_IOT0:
+            pinState_AddPin(transitionPtr, PIN_SDIO_SELECT, false);
+            break;
+
+        default:
+            LE_ERROR("Invalid SDIO route (%d)", route);
+            return LE_BAD_PARAMETER;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the pin changes that route audio as requested to a transition.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_BAD_PARAMETER if the route is not valid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t routing_AddAudio
+(
+    pinState_Transition_t* transitionPtr,  ///< Transition to add to
+    mangoh_muxCtrl_AudioRoute_t route      ///< Requested route
+)
+{
+    switch (route)
+    {
+        case MANGOH_MUXCTRL_AUDIO_DISABLED:
+            pinState_AddPin(transitionPtr, PIN_PCM_ENABLE, false);
+            pinState_AddPin(transitionPtr, PIN_PCM_ANALOG_SELECT, false);
+            break;
+
+        case MANGOH_MUXCTRL_AUDIO_IOT0_CODEC:
+            pinState_AddPin(transitionPtr, PIN_PCM_SELECT, false);
+            pinState_AddPin(transitionPtr, PIN_PCM_ANALOG_SELECT, false);
+            pinState_AddPin(transitionPtr, PIN_PCM_ENABLE, true);
+            break;
+
+        case MANGOH_MUXCTRL_AUDIO_ONBOARD_CODEC:
+            pinState_AddPin(transitionPtr, PIN_PCM_SELECT, true);
+            pinState_AddPin(transitionPtr, PIN_PCM_ANALOG_SELECT, false);
+            pinState_AddPin(transitionPtr, PIN_PCM_ENABLE, true);
+            break;
+
+        case MANGOH_MUXCTRL_AUDIO_INTERNAL_CODEC:
+            pinState_AddPin(transitionPtr, PIN_PCM_ENABLE, false);
+            pinState_AddPin(transitionPtr, PIN_PCM_ANALOG_SELECT, true);
+            break;
+
+        default:
+            LE_ERROR("Invalid audio route (%d)", route);
+            return LE_BAD_PARAMETER;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the pin that holds a reset target in reset.
+ *
+ * @return
+ *      The pin, or PIN_COUNT if the target is not valid
+ */
+//--------------------------------------------------------------------------------------------------
+pinState_Pin_t routing_GetResetPin
+(
+    mangoh_muxCtrl_ResetTarget_t target    ///< Reset target
+)
+{
+    switch (target)
+    {
+        case MANGOH_MUXCTRL_RESET_IOT0:
+            return PIN_IOT0_RESET;
+
+        case MANGOH_MUXCTRL_RESET_IOT1:
+            return PIN_IOT1_RESET;
+
+        case MANGOH_MUXCTRL_RESET_IOT2:
+            return PIN_IOT2_RESET;
+
+        case MANGOH_MUXCTRL_RESET_ARDUINO:
+            return PIN_ARDUINO_RESET;
+
+        default:
+            return PIN_COUNT;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the pin change that puts a reset target in or out of reset to a transition.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_BAD_PARAMETER if the target is not valid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t routing_AddReset
+(
+    pinState_Transition_t* transitionPtr,  ///< Transition to add to
+    mangoh_muxCtrl_ResetTarget_t target,   ///< Reset target
+    bool asserted                          ///< true to put the target in reset
+)
+{
+    pinState_Pin_t pin = routing_GetResetPin(target);
+
+    if (pin == PIN_COUNT)
+    {
+        LE_ERROR("Invalid reset target (%d)", target);
+        return LE_BAD_PARAMETER;
+    }
+
+    pinState_AddPin(transitionPtr, pin, asserted);
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Helpers for routing_GetPosition().  PIN_KNOWN() must be checked before PIN_ACTIVE() is used.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PIN_KNOWN(pin)  ((knownMask & (1 << (pin))) != 0)
+#define PIN_ACTIVE(pin) ((activeMask & (1 << (pin))) != 0)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Work out the position of a mux or reset line from the state of its pins.  This is the reverse of
+ * the routing_Add functions.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_UNAVAILABLE if the state of a pin that decides the position is not known
+ *      - LE_BAD_PARAMETER if the group is not valid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t routing_GetPosition
+(
+    mangoh_muxCtrl_MuxGroup_t group,  ///< Mux or reset line
+    uint32_t knownMask,               ///< Pins whose state is known (from pinState_GetSnapshot())
+    uint32_t activeMask,              ///< Pins that are active (from pinState_GetSnapshot())
+    int32_t* positionPtr              ///< [OUT] Position; see mangoh_muxCtrl_MuxGroup_t
+)
+{
+    pinState_Pin_t resetPin = PIN_COUNT;
+
+    switch (group)
+    {
+        case MANGOH_MUXCTRL_MUX_UART1:
+            if (!PIN_KNOWN(PIN_UART1_ENABLE) ||
+                (PIN_ACTIVE(PIN_UART1_ENABLE) && !PIN_KNOWN(PIN_UART1_SELECT)))
+            {
+                return LE_UNAVAILABLE;
+            }
+            *positionPtr = !PIN_ACTIVE(PIN_UART1_ENABLE) ? MANGOH_MUXCTRL_UART1_OFF :
+                           PIN_ACTIVE(PIN_UART1_SELECT)  ? MANGOH_MUXCTRL_UART1_IOT0 :
+                                                           MANGOH_MUXCTRL_UART1_IOT1;
+            return LE_OK;
+
+        case MANGOH_MUXCTRL_MUX_SPI:
+            if (!PIN_KNOWN(PIN_SPI_ENABLE) ||
+                (PIN_ACTIVE(PIN_SPI_ENABLE) && !PIN_KNOWN(PIN_SPI_SELECT)))
+            {
+                return LE_UNAVAILABLE;
+            }
+            *positionPtr = !PIN_ACTIVE(PIN_SPI_ENABLE) ? MANGOH_MUXCTRL_SPI_OFF :
+                           PIN_ACTIVE(PIN_SPI_SELECT)  ? MANGOH_MUXCTRL_SPI_IOT0 :
+                                                         MANGOH_MUXCTRL_SPI_IOT1;
+            return LE_OK;
+
+        case MANGOH_MUXCTRL_MUX_UART2:
+            if (!PIN_KNOWN(PIN_UART2_ENABLE) ||
+                (PIN_ACTIVE(PIN_UART2_ENABLE) && !PIN_KNOWN(PIN_UART2_SELECT)))
+            {
+                return LE_UNAVAILABLE;
+            }
+            *positionPtr = !PIN_ACTIVE(PIN_UART2_ENABLE) ? MANGOH_MUXCTRL_UART2_OFF :
+                           PIN_ACTIVE(PIN_UART2_SELECT)  ? MANGOH_MUXCTRL_UART2_IOT2 :
+                                                           MANGOH_MUXCTRL_UART2_DEBUG;
+            return LE_OK;
+
+        case MANGOH_MUXCTRL_MUX_SDIO:
+            if (!PIN_KNOWN(PIN_SDIO_SELECT))
+            {
+                return LE_UNAVAILABLE;
+            }
+            *positionPtr = PIN_ACTIVE(PIN_SDIO_SELECT) ? MANGOH_MUXCTRL_SDIO_MICROSD :
+                                                         MANGOH_MUXCTRL_SDIO_IOT0;
+            return LE_OK;
+
+        case MANGOH_MUXCTRL_MUX_AUDIO:
+            if (!PIN_KNOWN(PIN_PCM_ENABLE))
+            {
+                return LE_UNAVAILABLE;
+            }
+            if (PIN_ACTIVE(PIN_PCM_ENABLE))
+            {
+                if (!PIN_KNOWN(PIN_PCM_SELECT))
+                {
+                    return LE_UNAVAILABLE;
+                }
+                *positionPtr = PIN_ACTIVE(PIN_PCM_SELECT) ? MANGOH_MUXCTRL_AUDIO_ONBOARD_CODEC :
+                                                            MANGOH_MUXCTRL_AUDIO_IOT0_CODEC;
+            }
+            else
+            {
+                if (!PIN_KNOWN(PIN_PCM_ANALOG_SELECT))
+                {
+                    return LE_UNAVAILABLE;
+                }
+                *positionPtr = PIN_ACTIVE(PIN_PCM_ANALOG_SELECT) ?
+                                   MANGOH_MUXCTRL_AUDIO_INTERNAL_CODEC :
+                                   MANGOH_MUXCTRL_AUDIO_DISABLED;
+            }
+            return LE_OK;
+
+        case MANGOH_MUXCTRL_MUX_RESET_IOT0:
+            resetPin = PIN_IOT0_RESET;
+            break;
+        case MANGOH_MUXCTRL_MUX_RESET_IOT1:
+            resetPin = PIN_IOT1_RESET;
+            break;
+        case MANGOH_MUXCTRL_MUX_RESET_IOT2:
+            resetPin = PIN_IOT2_RESET;
+            break;
+        case MANGOH_MUXCTRL_MUX_RESET_ARDUINO:
+            resetPin = PIN_ARDUINO_RESET;
+            break;
+
+        default:
+            return LE_BAD_PARAMETER;
+    }
+
+    if (!PIN_KNOWN(resetPin))
+    {
+        return LE_UNAVAILABLE;
+    }
+    *positionPtr = PIN_ACTIVE(resetPin) ? 1 : 0;
+
+    return LE_OK;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file routing.h
+ *
+ * Translation of mux routings into the pin changes that select them.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#ifndef MUXCTRL_ROUTING_H_INCLUDE_GUARD
+#define MUXCTRL_ROUTING_H_INCLUDE_GUARD
+
+#include "pinState.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the pin changes that route UART 1 as requested to a transition.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_BAD_PARAMETER if the route is not valid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t routing_AddUart1
+(
+    pinState_Transition_t* transitionPtr,  ///< Transition to add to
+    mangoh_muxCtrl_Uart1Route_t route      ///< Requested route
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the pin changes that route SPI as requested to a transition.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_BAD_PARAMETER if the route is not valid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t routing_AddSpi
+(
+    pinState_Transition_t* transitionPtr,  ///< Transition to add to
+    mangoh_muxCtrl_SpiRoute_t route        ///< Requested route
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the pin changes that route UART 2 as requested to a transition.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_BAD_PARAMETER if the route is not valid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t routing_AddUart2
+(
+    pinState_Transition_t* transitionPtr,  ///< Transition to add to
+    mangoh_muxCtrl_Uart2Route_t route      ///< Requested route
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the pin changes that route SDIO as requested to a transition.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_BAD_PARAMETER if the route is not valid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t routing_AddSdio
+(
+    pinState_Transition_t* transitionPtr,  ///< Transition to add to
+    mangoh_muxCtrl_SdioRoute_t route       ///< Requested route
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the pin changes that route audio as requested to a transition.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_BAD_PARAMETER if the route is not valid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t routing_AddAudio
+(
+    pinState_Transition_t* transitionPtr,  ///< Transition to add to
+    mangoh_muxCtrl_AudioRoute_t route      ///< Requested route
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the pin that holds a reset target in reset.
+ *
+ * @return
+ *      The pin, or PIN_COUNT if the target is not valid
+ */
+//--------------------------------------------------------------------------------------------------
+pinState_Pin_t routing_GetResetPin
+(
+    mangoh_muxCtrl_ResetTarget_t target    ///< Reset target
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the pin change that puts a reset target in or out of reset to a transition.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_BAD_PARAMETER if the target is not valid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t routing_AddReset
+(
+    pinState_Transition_t* transitionPtr,  ///< Transition to add to
+    mangoh_muxCtrl_ResetTarget_t target,   ///< Reset target
+    bool asserted                          ///< true to put the target in reset
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Work out the position of a mux or reset line from the state of its pins.  This is the reverse of
+ * the routing_Add functions.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_UNAVAILABLE if the state of a pin that decides the position is not known
+ *      - LE_BAD_PARAMETER if the group is not valid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t routing_GetPosition
+(
+    mangoh_muxCtrl_MuxGroup_t group,  ///< Mux or reset line
+    uint32_t knownMask,               ///< Pins whose state is known (from pinState_GetSnapshot())
+    uint32_t activeMask,              ///< Pins that are active (from pinState_GetSnapshot())
+    int32_t* positionPtr              ///< [OUT] Position; see mangoh_muxCtrl_MuxGroup_t
+);
+
+#endif // MUXCTRL_ROUTING_H_INCLUDE_GUARD
@@ -0,0 +1,531 @@
+/**
+ * @file scheduler.c
+ *
+ * Time-sliced sharing of UART 1 and SPI between IoT slots 0 and 1, and the SlotSwitch event that
+ * reports the slot boundaries.
+ *
+ * A schedule is a repeating list of slices, each giving the bus to one slot for a number of
+ * milliseconds.  At each boundary the outgoing slot is told its slice is ending, the bus is left
+ * idle for the guard time so its user can drain it, the mux is switched, and the incoming slot is
+ * told its slice has started so its user can prime the bus.
+ *
+ * Switches are queued like any other request, as if from the client that started the schedule,
+ * so they are serialised with everything else the service does.  That client holds the lease on
+ * the bus while the schedule runs, so other clients can't switch it in between.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "lease.h"
+#include "scheduler.h"
+#include "sessionHandlers.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of buses that can be scheduled: UART 1 and SPI, numbered like their mux groups.
+ */
+//--------------------------------------------------------------------------------------------------
+#define NUM_BUSES (MANGOH_MUXCTRL_MUX_SPI + 1)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of IoT slots a bus can be switched between.
+ */
+//--------------------------------------------------------------------------------------------------
+#define NUM_SLOTS 2
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * What the schedule of a bus is doing.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    PHASE_IDLE,         ///< No schedule
+    PHASE_SWITCHING,    ///< Waiting for the mux to switch to the current slice's slot
+    PHASE_SLICE,        ///< In the current slice
+    PHASE_GUARD         ///< Between the end of the current slice and the switch to the next
+}
+Phase_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report sent through the SlotSwitch event.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    mangoh_muxCtrl_MuxGroup_t bus;
+    uint8_t slot;
+    mangoh_muxCtrl_SlotEvent_t event;
+}
+SlotSwitch_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Operation that gives each bus to each slot.
+ */
+//--------------------------------------------------------------------------------------------------
+static const mangoh_muxCtrl_Operation_t SlotOps[NUM_BUSES][NUM_SLOTS] =
+{
+    [MANGOH_MUXCTRL_MUX_UART1] =
+        { MANGOH_MUXCTRL_OP_IOT0_UART1_ON, MANGOH_MUXCTRL_OP_IOT1_UART1_ON },
+    [MANGOH_MUXCTRL_MUX_SPI] =
+        { MANGOH_MUXCTRL_OP_IOT0_SPI1_ON, MANGOH_MUXCTRL_OP_IOT1_SPI1_ON },
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Schedule of each bus.
+ */
+//--------------------------------------------------------------------------------------------------
+static struct
+{
+    le_msg_SessionRef_t ownerRef;   ///< Session that started the schedule, or NULL if there is none
+    struct
+    {
+        uint8_t slot;
+        uint32_t ms;
+    } slices[MANGOH_MUXCTRL_MAX_SCHEDULE_LEN];
+    size_t numSlices;
+    uint32_t guardMs;
+    size_t current;                 ///< Index of the slice that has (or is getting) the bus
+    int activeSlot;                 ///< Slot the bus is switched to, or -1 if not known
+    Phase_t phase;
+    le_timer_Ref_t timer;           ///< Ends slices and guard times
+    uintptr_t generation;           ///< Changes whenever a schedule stops, so that the result of
+                                    ///< a switch queued for an old schedule is ignored
+}
+Buses[NUM_BUSES];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Function used to switch the buses.
+ */
+//--------------------------------------------------------------------------------------------------
+static scheduler_SwitchFunc_t SwitchFunc;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Event used to report slot boundaries.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_event_Id_t SlotSwitchEventId;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Registered SlotSwitch handlers.
+ */
+//--------------------------------------------------------------------------------------------------
+static sessionHandlers_List_t Handlers;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pass a slot boundary on to a client's handler.
+ */
+//--------------------------------------------------------------------------------------------------
+static void FirstLayerSlotSwitchHandler
+(
+    void* reportPtr,
+    void* secondLayerHandlerFunc
+)
+{
+    const SlotSwitch_t* switchPtr = reportPtr;
+    mangoh_muxCtrl_SlotSwitchHandlerFunc_t clientHandlerFunc = secondLayerHandlerFunc;
+
+    clientHandlerFunc(switchPtr->bus, switchPtr->slot, switchPtr->event,
+                      le_event_GetContextPtr());
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report a slot boundary.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Report
+(
+    mangoh_muxCtrl_MuxGroup_t bus,
+    uint8_t slot,
+    mangoh_muxCtrl_SlotEvent_t event
+)
+{
+    SlotSwitch_t report = { .bus = bus, .slot = slot, .event = event };
+
+    le_event_Report(SlotSwitchEventId, &report, sizeof(report));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the context passed with the switches of the current schedule of a bus.
+ */
+//--------------------------------------------------------------------------------------------------
+static void* SwitchContext
+(
+    mangoh_muxCtrl_MuxGroup_t bus
+)
+{
+    return (void*)(Buses[bus].generation * NUM_BUSES + bus);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run the timer of a bus for a number of milliseconds.
+ */
+//--------------------------------------------------------------------------------------------------
+static void StartTimer
+(
+    mangoh_muxCtrl_MuxGroup_t bus,
+    uint32_t ms
+)
+{
+    le_timer_Stop(Buses[bus].timer);
+    le_timer_SetMsInterval(Buses[bus].timer, ms);
+    le_timer_Start(Buses[bus].timer);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Called when the switch of a bus to the slot of its current slice is complete.  The slice runs
+ * even if the switch failed, so the schedule keeps its timing and tries again at the next
+ * boundary.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SwitchDone
+(
+    le_result_t result,
+    void* contextPtr
+)
+{
+    mangoh_muxCtrl_MuxGroup_t bus;
+
+    for (bus = 0; bus < NUM_BUSES; bus++)
+    {
+        if ((Buses[bus].phase == PHASE_SWITCHING) && (SwitchContext(bus) == contextPtr))
+        {
+            break;
+        }
+    }
+    if (bus == NUM_BUSES)
+    {
+        // The schedule this switch was for has stopped.
+        return;
+    }
+
+    uint8_t slot = Buses[bus].slices[Buses[bus].current].slot;
+
+    if (result == LE_OK)
+    {
+        Buses[bus].activeSlot = slot;
+        Report(bus, slot, MANGOH_MUXCTRL_SLOT_STARTED);
+    }
+    else
+    {
+        LE_ERROR("Failed to switch mux group %d to IoT slot %u (%d)", bus, slot, result);
+        Buses[bus].activeSlot = -1;
+        Report(bus, slot, MANGOH_MUXCTRL_SLOT_SWITCH_FAILED);
+    }
+
+    Buses[bus].phase = PHASE_SLICE;
+    StartTimer(bus, Buses[bus].slices[Buses[bus].current].ms);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Give a bus to the slot of one of its slices.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SwitchTo
+(
+    mangoh_muxCtrl_MuxGroup_t bus,
+    size_t index    ///< Index of the slice
+)
+{
+    Buses[bus].current = index;
+    Buses[bus].activeSlot = -1;
+    Buses[bus].phase = PHASE_SWITCHING;
+
+    SwitchFunc(SlotOps[bus][Buses[bus].slices[index].slot],
+               Buses[bus].ownerRef,
+               SwitchDone,
+               SwitchContext(bus));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * End the current slice or guard time of a bus.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TimerExpired
+(
+    le_timer_Ref_t timer
+)
+{
+    mangoh_muxCtrl_MuxGroup_t bus = (intptr_t)le_timer_GetContextPtr(timer);
+    size_t next = (Buses[bus].current + 1) % Buses[bus].numSlices;
+
+    switch (Buses[bus].phase)
+    {
+        case PHASE_SLICE:
+            if (Buses[bus].slices[next].slot == Buses[bus].activeSlot)
+            {
+                // The same slot keeps the bus; there is no boundary.
+                Buses[bus].current = next;
+                StartTimer(bus, Buses[bus].slices[next].ms);
+            }
+            else if ((Buses[bus].activeSlot >= 0) && (Buses[bus].guardMs > 0))
+            {
+                Report(bus, Buses[bus].activeSlot, MANGOH_MUXCTRL_SLOT_ENDING);
+                Buses[bus].phase = PHASE_GUARD;
+                StartTimer(bus, Buses[bus].guardMs);
+            }
+            else
+            {
+                if (Buses[bus].activeSlot >= 0)
+                {
+                    Report(bus, Buses[bus].activeSlot, MANGOH_MUXCTRL_SLOT_ENDING);
+                }
+                SwitchTo(bus, next);
+            }
+            break;
+
+        case PHASE_GUARD:
+            SwitchTo(bus, next);
+            break;
+
+        case PHASE_IDLE:
+        case PHASE_SWITCHING:
+            break;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the schedule of a bus.  The slot that has the bus is told its slice is ending, unless it
+ * already has been.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Halt
+(
+    mangoh_muxCtrl_MuxGroup_t bus
+)
+{
+    le_timer_Stop(Buses[bus].timer);
+
+    if ((Buses[bus].phase == PHASE_SLICE) && (Buses[bus].activeSlot >= 0))
+    {
+        Report(bus, Buses[bus].activeSlot, MANGOH_MUXCTRL_SLOT_ENDING);
+    }
+
+    Buses[bus].ownerRef = NULL;
+    Buses[bus].phase = PHASE_IDLE;
+    Buses[bus].activeSlot = -1;
+    Buses[bus].generation++;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Create the SlotSwitch event and the slice timers.
+ */
+//--------------------------------------------------------------------------------------------------
+void scheduler_Init
+(
+    scheduler_SwitchFunc_t switchFunc  ///< Function used to switch the buses
+)
+{
+    SwitchFunc = switchFunc;
+    SlotSwitchEventId = le_event_CreateId("Slot switch", sizeof(SlotSwitch_t));
+    sessionHandlers_Init(&Handlers, "slot switch", SlotSwitchEventId, FirstLayerSlotSwitchHandler);
+
+    for (int bus = 0; bus < NUM_BUSES; bus++)
+    {
+        Buses[bus].activeSlot = -1;
+        Buses[bus].timer = le_timer_Create(bus == MANGOH_MUXCTRL_MUX_UART1 ? "UART 1 schedule" :
+                                                                             "SPI schedule");
+        le_timer_SetHandler(Buses[bus].timer, TimerExpired);
+        le_timer_SetContextPtr(Buses[bus].timer, (void*)(intptr_t)bus);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start (or replace) the schedule of a client session on a bus, and take the lease on the bus
+ * for the session.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_BUSY if another session holds the lease on the bus
+ *      - LE_BAD_PARAMETER if the bus or the schedule is not valid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t scheduler_Start
+(
+    mangoh_muxCtrl_MuxGroup_t bus,  ///< MANGOH_MUXCTRL_MUX_UART1 or MANGOH_MUXCTRL_MUX_SPI
+    const uint8_t* slotsPtr,        ///< IoT slot of each slice
+    size_t numSlots,
+    const uint32_t* slicesMsPtr,    ///< Length of each slice in milliseconds
+    size_t numSlices,
+    uint32_t guardMs,               ///< Time between SLOT_ENDING and the switch
+    le_msg_SessionRef_t sessionRef  ///< Session starting the schedule
+)
+{
+    if ((bus < 0) || (bus >= NUM_BUSES))
+    {
+        LE_ERROR("Mux group %d can't be scheduled", bus);
+        return LE_BAD_PARAMETER;
+    }
+
+    if ((numSlots == 0) || (numSlots != numSlices) ||
+        (numSlots > MANGOH_MUXCTRL_MAX_SCHEDULE_LEN) || (guardMs > MANGOH_MUXCTRL_MAX_GUARD_MS))
+    {
+        LE_ERROR("Invalid schedule: %zu slots, %zu slices, guard time %u ms",
+                 numSlots, numSlices, guardMs);
+        return LE_BAD_PARAMETER;
+    }
+
+    for (size_t i = 0; i < numSlots; i++)
+    {
+        if ((slotsPtr[i] >= NUM_SLOTS) ||
+            (slicesMsPtr[i] < MANGOH_MUXCTRL_MIN_SLICE_MS) ||
+            (slicesMsPtr[i] > MANGOH_MUXCTRL_MAX_SLICE_MS))
+        {
+            LE_ERROR("Invalid slice %zu: IoT slot %u for %u ms", i, slotsPtr[i], slicesMsPtr[i]);
+            return LE_BAD_PARAMETER;
+        }
+    }
+
+    // This also refuses a schedule while another client runs one, as it holds the lease.
+    le_result_t result = lease_Acquire(bus, sessionRef);
+    if (result != LE_OK)
+    {
+        return result;
+    }
+
+    if (Buses[bus].ownerRef != NULL)
+    {
+        Halt(bus);
+    }
+
+    Buses[bus].ownerRef = sessionRef;
+    Buses[bus].numSlices = numSlices;
+    Buses[bus].guardMs = guardMs;
+    for (size_t i = 0; i < numSlices; i++)
+    {
+        Buses[bus].slices[i].slot = slotsPtr[i];
+        Buses[bus].slices[i].ms = slicesMsPtr[i];
+    }
+
+    LE_INFO("Starting a schedule of %zu slices on mux group %d", numSlices, bus);
+    SwitchTo(bus, 0);
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the schedule of a client session on a bus and give up its lease on the bus.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_NOT_PERMITTED if the session does not run a schedule on the bus
+ *      - LE_BAD_PARAMETER if the bus is not valid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t scheduler_Stop
+(
+    mangoh_muxCtrl_MuxGroup_t bus,
+    le_msg_SessionRef_t sessionRef
+)
+{
+    if ((bus < 0) || (bus >= NUM_BUSES))
+    {
+        LE_ERROR("Mux group %d can't be scheduled", bus);
+        return LE_BAD_PARAMETER;
+    }
+
+    if ((sessionRef == NULL) || (Buses[bus].ownerRef != sessionRef))
+    {
+        return LE_NOT_PERMITTED;
+    }
+
+    Halt(bus);
+    lease_Release(bus, sessionRef);
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether a client session runs a schedule on a mux group.
+ *
+ * @return
+ *      true if the session runs a schedule on the group (which is never the case for a group that
+ *      can't be scheduled).
+ */
+//--------------------------------------------------------------------------------------------------
+bool scheduler_IsRunning
+(
+    mangoh_muxCtrl_MuxGroup_t bus,
+    le_msg_SessionRef_t sessionRef
+)
+{
+    return (bus >= 0) && (bus < NUM_BUSES) && (sessionRef != NULL) &&
+           (Buses[bus].ownerRef == sessionRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Register a SlotSwitch handler for the client of the message being handled.
+ */
+//--------------------------------------------------------------------------------------------------
+mangoh_muxCtrl_SlotSwitchHandlerRef_t scheduler_AddHandler
+(
+    mangoh_muxCtrl_SlotSwitchHandlerFunc_t handlerPtr,  ///< Handler to call
+    void* contextPtr                                    ///< Passed to the handler
+)
+{
+    return (mangoh_muxCtrl_SlotSwitchHandlerRef_t)sessionHandlers_Add(&Handlers, handlerPtr,
+                                                                      contextPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove a SlotSwitch handler.
+ */
+//--------------------------------------------------------------------------------------------------
+void scheduler_RemoveHandler
+(
+    mangoh_muxCtrl_SlotSwitchHandlerRef_t handlerRef  ///< Handler to remove
+)
+{
+    sessionHandlers_Remove(&Handlers, (le_event_HandlerRef_t)handlerRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the schedules and remove the SlotSwitch handlers of a client session that has closed.
+ */
+//--------------------------------------------------------------------------------------------------
+void scheduler_SessionClosed
+(
+    le_msg_SessionRef_t sessionRef
+)
+{
+    sessionHandlers_RemoveSession(&Handlers, sessionRef);
+
+    for (int bus = 0; bus < NUM_BUSES; bus++)
+    {
+        if (Buses[bus].ownerRef == sessionRef)
+        {
+            LE_INFO("Stopping the schedule on mux group %d of a closed session", bus);
+            scheduler_Stop(bus, sessionRef);
+        }
+    }
+}
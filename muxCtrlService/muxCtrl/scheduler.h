@@ -0,0 +1,119 @@
+/**
+ * @file scheduler.h
+ *
+ * Time-sliced sharing of UART 1 and SPI between IoT slots 0 and 1, and the SlotSwitch event that
+ * reports the slot boundaries.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#ifndef MUXCTRL_SCHEDULER_H_INCLUDE_GUARD
+#define MUXCTRL_SCHEDULER_H_INCLUDE_GUARD
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Function the scheduler uses to switch a bus.  The switch is queued like an asynchronous request
+ * from the given client session, and doneFunc is called with its result.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*scheduler_SwitchFunc_t)
+(
+    mangoh_muxCtrl_Operation_t op,                   ///< Operation that switches the bus
+    le_msg_SessionRef_t sessionRef,                  ///< Session the switch is made for
+    mangoh_muxCtrl_CompletionHandlerFunc_t doneFunc, ///< Called when the switch is complete
+    void* contextPtr                                 ///< Passed to doneFunc
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Create the SlotSwitch event and the slice timers.
+ */
+//--------------------------------------------------------------------------------------------------
+void scheduler_Init
+(
+    scheduler_SwitchFunc_t switchFunc  ///< Function used to switch the buses
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start (or replace) the schedule of a client session on a bus, and take the lease on the bus
+ * for the session.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_BUSY if another session holds the lease on the bus
+ *      - LE_BAD_PARAMETER if the bus or the schedule is not valid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t scheduler_Start
+(
+    mangoh_muxCtrl_MuxGroup_t bus,  ///< MANGOH_MUXCTRL_MUX_UART1 or MANGOH_MUXCTRL_MUX_SPI
+    const uint8_t* slotsPtr,        ///< IoT slot of each slice
+    size_t numSlots,
+    const uint32_t* slicesMsPtr,    ///< Length of each slice in milliseconds
+    size_t numSlices,
+    uint32_t guardMs,               ///< Time between SLOT_ENDING and the switch
+    le_msg_SessionRef_t sessionRef  ///< Session starting the schedule
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the schedule of a client session on a bus and give up its lease on the bus.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_NOT_PERMITTED if the session does not run a schedule on the bus
+ *      - LE_BAD_PARAMETER if the bus is not valid
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t scheduler_Stop
+(
+    mangoh_muxCtrl_MuxGroup_t bus,
+    le_msg_SessionRef_t sessionRef
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether a client session runs a schedule on a mux group.
+ */
+//--------------------------------------------------------------------------------------------------
+bool scheduler_IsRunning
+(
+    mangoh_muxCtrl_MuxGroup_t bus,
+    le_msg_SessionRef_t sessionRef
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Register a SlotSwitch handler for the client of the message being handled.
+ */
+//--------------------------------------------------------------------------------------------------
+mangoh_muxCtrl_SlotSwitchHandlerRef_t scheduler_AddHandler
+(
+    mangoh_muxCtrl_SlotSwitchHandlerFunc_t handlerPtr,  ///< Handler to call
+    void* contextPtr                                    ///< Passed to the handler
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove a SlotSwitch handler.
+ */
+//--------------------------------------------------------------------------------------------------
+void scheduler_RemoveHandler
+(
+    mangoh_muxCtrl_SlotSwitchHandlerRef_t handlerRef  ///< Handler to remove
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the schedules and remove the SlotSwitch handlers of a client session that has closed.
+ */
+//--------------------------------------------------------------------------------------------------
+void scheduler_SessionClosed
+(
+    le_msg_SessionRef_t sessionRef
+);
+
+#endif // MUXCTRL_SCHEDULER_H_INCLUDE_GUARD
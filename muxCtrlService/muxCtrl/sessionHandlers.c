@@ -0,0 +1,168 @@
+/**
+ * @file sessionHandlers.c
+ *
+ * Lists of the layered event handlers that clients register, each tagged with the session of the
+ * client that registered it so they can be removed when the session closes.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "sessionHandlers.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * A registered handler.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_sls_Link_t link;                 ///< Link in the list's handlers
+    le_event_HandlerRef_t eventHandlerRef;
+    le_msg_SessionRef_t sessionRef;     ///< Session of the client that registered it
+}
+Handler_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pool the handlers of all the lists are allocated from.  Created with the first list.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t HandlerPool;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove the handler entry that follows prevLinkPtr (or the first one if it is NULL).
+ */
+//--------------------------------------------------------------------------------------------------
+static void RemoveAfter
+(
+    sessionHandlers_List_t* listPtr,
+    le_sls_Link_t* prevLinkPtr
+)
+{
+    le_sls_Link_t* linkPtr = (prevLinkPtr == NULL) ?
+                                 le_sls_Pop(&listPtr->handlers) :
+                                 le_sls_RemoveAfter(&listPtr->handlers, prevLinkPtr);
+    Handler_t* handlerEntryPtr = CONTAINER_OF(linkPtr, Handler_t, link);
+
+    le_event_RemoveHandler(handlerEntryPtr->eventHandlerRef);
+    le_mem_Release(handlerEntryPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize an empty handler list for an event.
+ */
+//--------------------------------------------------------------------------------------------------
+void sessionHandlers_Init
+(
+    sessionHandlers_List_t* listPtr,                ///< List to initialize
+    const char* name,                               ///< Name of the event, for messages
+    le_event_Id_t eventId,                          ///< Event the handlers are added to
+    le_event_LayeredHandlerFunc_t firstLayerFunc    ///< Calls a client's handler for the event
+)
+{
+    if (HandlerPool == NULL)
+    {
+        HandlerPool = le_mem_CreatePool("Client event handlers", sizeof(Handler_t));
+    }
+
+    listPtr->handlers = LE_SLS_LIST_INIT;
+    listPtr->name = name;
+    listPtr->eventId = eventId;
+    listPtr->firstLayerFunc = firstLayerFunc;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a handler for the client of the message being handled.
+ *
+ * @return
+ *      Reference to the handler, to be returned to the client
+ */
+//--------------------------------------------------------------------------------------------------
+le_event_HandlerRef_t sessionHandlers_Add
+(
+    sessionHandlers_List_t* listPtr,    ///< List to add the handler to
+    void* handlerPtr,                   ///< Client's handler
+    void* contextPtr                    ///< Passed to the client's handler
+)
+{
+    Handler_t* handlerEntryPtr = le_mem_ForceAlloc(HandlerPool);
+    handlerEntryPtr->link = LE_SLS_LINK_INIT;
+    handlerEntryPtr->sessionRef = mangoh_muxCtrl_GetClientSessionRef();
+    handlerEntryPtr->eventHandlerRef = le_event_AddLayeredHandler(listPtr->name,
+                                                                  listPtr->eventId,
+                                                                  listPtr->firstLayerFunc,
+                                                                  handlerPtr);
+    le_event_SetContextPtr(handlerEntryPtr->eventHandlerRef, contextPtr);
+    le_sls_Queue(&listPtr->handlers, &handlerEntryPtr->link);
+
+    return handlerEntryPtr->eventHandlerRef;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove a handler.  An unknown reference is logged and ignored.
+ */
+//--------------------------------------------------------------------------------------------------
+void sessionHandlers_Remove
+(
+    sessionHandlers_List_t* listPtr,    ///< List the handler is in
+    le_event_HandlerRef_t handlerRef    ///< Handler to remove
+)
+{
+    le_sls_Link_t* prevLinkPtr = NULL;
+
+    for (le_sls_Link_t* linkPtr = le_sls_Peek(&listPtr->handlers);
+         linkPtr != NULL;
+         prevLinkPtr = linkPtr, linkPtr = le_sls_PeekNext(&listPtr->handlers, linkPtr))
+    {
+        Handler_t* handlerEntryPtr = CONTAINER_OF(linkPtr, Handler_t, link);
+        if (handlerEntryPtr->eventHandlerRef == handlerRef)
+        {
+            RemoveAfter(listPtr, prevLinkPtr);
+            return;
+        }
+    }
+
+    LE_ERROR("Invalid %s handler reference (%p)", listPtr->name, handlerRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove all the handlers of a client session that has closed.
+ */
+//--------------------------------------------------------------------------------------------------
+void sessionHandlers_RemoveSession
+(
+    sessionHandlers_List_t* listPtr,    ///< List to remove the handlers from
+    le_msg_SessionRef_t sessionRef      ///< Session that has closed
+)
+{
+    le_sls_Link_t* prevLinkPtr = NULL;
+    le_sls_Link_t* linkPtr = le_sls_Peek(&listPtr->handlers);
+
+    while (linkPtr != NULL)
+    {
+        Handler_t* handlerEntryPtr = CONTAINER_OF(linkPtr, Handler_t, link);
+        if (handlerEntryPtr->sessionRef == sessionRef)
+        {
+            RemoveAfter(listPtr, prevLinkPtr);
+        }
+        else
+        {
+            prevLinkPtr = linkPtr;
+        }
+        linkPtr = (prevLinkPtr == NULL) ? le_sls_Peek(&listPtr->handlers) :
+                                          le_sls_PeekNext(&listPtr->handlers, prevLinkPtr);
+    }
+}
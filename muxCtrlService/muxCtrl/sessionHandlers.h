@@ -0,0 +1,79 @@
+/**
+ * @file sessionHandlers.h
+ *
+ * Lists of the layered event handlers that clients register, each tagged with the session of the
+ * client that registered it so they can be removed when the session closes.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#ifndef MUXCTRL_SESSION_HANDLERS_H_INCLUDE_GUARD
+#define MUXCTRL_SESSION_HANDLERS_H_INCLUDE_GUARD
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * A list of client handlers for one event.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_sls_List_t handlers;                         ///< Registered handlers
+    const char* name;                               ///< Name of the event, for messages
+    le_event_Id_t eventId;                          ///< Event the handlers are added to
+    le_event_LayeredHandlerFunc_t firstLayerFunc;   ///< Calls a client's handler for the event
+}
+sessionHandlers_List_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize an empty handler list for an event.
+ */
+//--------------------------------------------------------------------------------------------------
+void sessionHandlers_Init
+(
+    sessionHandlers_List_t* listPtr,                ///< List to initialize
+    const char* name,                               ///< Name of the event, for messages
+    le_event_Id_t eventId,                          ///< Event the handlers are added to
+    le_event_LayeredHandlerFunc_t firstLayerFunc    ///< Calls a client's handler for the event
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a handler for the client of the message being handled.
+ *
+ * @return
+ *      Reference to the handler, to be returned to the client
+ */
+//--------------------------------------------------------------------------------------------------
+le_event_HandlerRef_t sessionHandlers_Add
+(
+    sessionHandlers_List_t* listPtr,    ///< List to add the handler to
+    void* handlerPtr,                   ///< Client's handler
+    void* contextPtr                    ///< Passed to the client's handler
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove a handler.  An unknown reference is logged and ignored.
+ */
+//--------------------------------------------------------------------------------------------------
+void sessionHandlers_Remove
+(
+    sessionHandlers_List_t* listPtr,    ///< List the handler is in
+    le_event_HandlerRef_t handlerRef    ///< Handler to remove
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove all the handlers of a client session that has closed.
+ */
+//--------------------------------------------------------------------------------------------------
+void sessionHandlers_RemoveSession
+(
+    sessionHandlers_List_t* listPtr,    ///< List to remove the handlers from
+    le_msg_SessionRef_t sessionRef      ///< Session that has closed
+);
+
+#endif // MUXCTRL_SESSION_HANDLERS_H_INCLUDE_GUARD
@@ -0,0 +1,277 @@
+/**
+ * @file stats.c
+ *
+ * Call, pin and GPIO latency statistics of the mux control service.
+ *
+ * The counters are updated with relaxed atomic operations and no lock, so recording costs a few
+ * increments on the request path.  A reader may see the counters of a call that is still being
+ * recorded half updated, which is fine for statistics.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+#include <time.h>
+
+#include "pinState.h"
+#include "stats.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Names of the API calls, indexed by stats_Call_t.
+ */
+//--------------------------------------------------------------------------------------------------
+static const char* const CallNames[STATS_NUM_CALLS] =
+{
+    [MANGOH_MUXCTRL_OP_IOT_ALL_UART1_OFF]           = "IotAllUart1Off",
+    [MANGOH_MUXCTRL_OP_IOT0_UART1_ON]               = "Iot0Uart1On",
+    [MANGOH_MUXCTRL_OP_IOT1_UART1_ON]               = "Iot1Uart1On",
+    [MANGOH_MUXCTRL_OP_IOT_ALL_SPI_OFF]             = "IotAllSpiOff",
+    [MANGOH_MUXCTRL_OP_IOT0_SPI1_ON]                = "Iot0Spi1On",
+    [MANGOH_MUXCTRL_OP_IOT1_SPI1_ON]                = "Iot1Spi1On",
+    [MANGOH_MUXCTRL_OP_IOT_ALL_UART2_OFF]           = "IotAllUart2Off",
+    [MANGOH_MUXCTRL_OP_IOT2_UART2_ON]               = "Iot2Uart2On",
+    [MANGOH_MUXCTRL_OP_UART2_DEBUG_ON]              = "Uart2DebugOn",
+    [MANGOH_MUXCTRL_OP_SDIO_SEL_MICRO_SD]           = "SdioSelMicroSd",
+    [MANGOH_MUXCTRL_OP_SDIO_SEL_IOT0]               = "SdioSelIot0",
+    [MANGOH_MUXCTRL_OP_AUDIO_DISABLE]               = "AudioDisable",
+    [MANGOH_MUXCTRL_OP_AUDIO_SELECT_IOT0_CODEC]     = "AudioSelectIot0Codec",
+    [MANGOH_MUXCTRL_OP_AUDIO_SELECT_ONBOARD_CODEC]  = "AudioSelectOnboardCodec",
+    [MANGOH_MUXCTRL_OP_AUDIO_SELECT_INTERNAL_CODEC] = "AudioSelectInternalCodec",
+    [MANGOH_MUXCTRL_OP_IOT_SLOT0_DEASSERT_RESET]    = "IotSlot0DeassertReset",
+    [MANGOH_MUXCTRL_OP_IOT_SLOT1_DEASSERT_RESET]    = "IotSlot1DeassertReset",
+    [MANGOH_MUXCTRL_OP_IOT_SLOT2_DEASSERT_RESET]    = "IotSlot2DeassertReset",
+    [MANGOH_MUXCTRL_OP_ARDUINO_ASSERT_RESET]        = "ArduinoAssertReset",
+    [MANGOH_MUXCTRL_OP_ARDUINO_DEASSERT_RESET]      = "ArduinoDeassertReset",
+    [MANGOH_MUXCTRL_OP_ARDUINO_RESET]               = "ArduinoReset",
+    [STATS_CALL_PULSE_RESET]                        = "PulseReset",
+    [STATS_CALL_APPLY_CONFIGURATION]                = "ApplyConfiguration",
+    [STATS_CALL_EXECUTE_SEQUENCE]                   = "ExecuteSequence",
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Counters of each API call.
+ */
+//--------------------------------------------------------------------------------------------------
+static struct
+{
+    uint32_t calls;
+    uint32_t failures;
+}
+Calls[STATS_NUM_CALLS];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Counters of each pin.
+ */
+//--------------------------------------------------------------------------------------------------
+static struct
+{
+    uint32_t writes;
+    uint32_t failures;
+}
+Pins[PIN_COUNT];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * GPIO call latency histogram (see stats_GetGpioLatency()) and the longest call.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t LatencyBuckets[MANGOH_MUXCTRL_NUM_LATENCY_BUCKETS];
+static uint32_t MaxLatencyUs;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a time stamp to pass to stats_RecordGpioCall(): the CLOCK_MONOTONIC time in nanoseconds.
+ */
+//--------------------------------------------------------------------------------------------------
+uint64_t stats_GetTimeStamp
+(
+    void
+)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Record the result of an API call.  May be called from any thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void stats_RecordCall
+(
+    uint32_t call,          ///< stats_Call_t or mangoh_muxCtrl_Operation_t
+    le_result_t result      ///< Result of the call
+)
+{
+    // Invalid operations are rejected by the request path; they have no counters.
+    if (call >= STATS_NUM_CALLS)
+    {
+        return;
+    }
+
+    __atomic_add_fetch(&Calls[call].calls, 1, __ATOMIC_RELAXED);
+    if (result != LE_OK)
+    {
+        __atomic_add_fetch(&Calls[call].failures, 1, __ATOMIC_RELAXED);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Record a call to the GPIO backend that wrote some pins.  May be called from any thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void stats_RecordGpioCall
+(
+    uint32_t pinMask,       ///< Pins written (bit n is pinState_Pin_t n)
+    le_result_t result,     ///< Result of the backend call
+    uint64_t startTime      ///< Time stamp taken before the call by stats_GetTimeStamp()
+)
+{
+    uint64_t elapsedUs = (stats_GetTimeStamp() - startTime) / 1000;
+    uint32_t latencyUs = (elapsedUs > UINT32_MAX) ? UINT32_MAX : (uint32_t)elapsedUs;
+
+    int bucket = (latencyUs == 0) ? 0 : (32 - __builtin_clz(latencyUs));
+    if (bucket >= MANGOH_MUXCTRL_NUM_LATENCY_BUCKETS)
+    {
+        bucket = MANGOH_MUXCTRL_NUM_LATENCY_BUCKETS - 1;
+    }
+    __atomic_add_fetch(&LatencyBuckets[bucket], 1, __ATOMIC_RELAXED);
+
+    uint32_t maxUs = __atomic_load_n(&MaxLatencyUs, __ATOMIC_RELAXED);
+    while ((latencyUs > maxUs) &&
+           !__atomic_compare_exchange_n(&MaxLatencyUs, &maxUs, latencyUs, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+
+    while (pinMask != 0)
+    {
+        int pin = __builtin_ctz(pinMask);
+        pinMask &= pinMask - 1;
+
+        __atomic_add_fetch(&Pins[pin].writes, 1, __ATOMIC_RELAXED);
+        if (result != LE_OK)
+        {
+            __atomic_add_fetch(&Pins[pin].failures, 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the statistics of an API call.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_OUT_OF_RANGE if there is no call with that index
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t stats_GetCall
+(
+    uint32_t call,              ///< Index of the call
+    const char** namePtr,       ///< [OUT] Name of the API function
+    uint32_t* callsPtr,         ///< [OUT] Number of calls
+    uint32_t* failuresPtr       ///< [OUT] Number of calls that failed
+)
+{
+    if (call >= STATS_NUM_CALLS)
+    {
+        return LE_OUT_OF_RANGE;
+    }
+
+    *namePtr = CallNames[call];
+    *callsPtr = __atomic_load_n(&Calls[call].calls, __ATOMIC_RELAXED);
+    *failuresPtr = __atomic_load_n(&Calls[call].failures, __ATOMIC_RELAXED);
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the statistics of a pin.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_OUT_OF_RANGE if there is no pin with that index
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t stats_GetPin
+(
+    uint32_t pin,               ///< Index of the pin
+    const char** namePtr,       ///< [OUT] Name of the pin
+    uint32_t* writesPtr,        ///< [OUT] Number of GPIO calls that wrote the pin
+    uint32_t* failuresPtr       ///< [OUT] Number of those calls that failed
+)
+{
+    if (pin >= PIN_COUNT)
+    {
+        return LE_OUT_OF_RANGE;
+    }
+
+    *namePtr = pinState_GetName(pin);
+    *writesPtr = __atomic_load_n(&Pins[pin].writes, __ATOMIC_RELAXED);
+    *failuresPtr = __atomic_load_n(&Pins[pin].failures, __ATOMIC_RELAXED);
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the latency histogram of the GPIO backend calls.  Bucket 0 counts calls that took less than
+ * 1 microsecond, bucket n calls that took from 2^(n-1) up to 2^n microseconds, and the last bucket
+ * every longer call.
+ */
+//--------------------------------------------------------------------------------------------------
+void stats_GetGpioLatency
+(
+    uint32_t* bucketsPtr,       ///< [OUT] MANGOH_MUXCTRL_NUM_LATENCY_BUCKETS buckets
+    uint32_t* maxUsPtr          ///< [OUT] Longest call, in microseconds
+)
+{
+    for (int i = 0; i < MANGOH_MUXCTRL_NUM_LATENCY_BUCKETS; i++)
+    {
+        bucketsPtr[i] = __atomic_load_n(&LatencyBuckets[i], __ATOMIC_RELAXED);
+    }
+    *maxUsPtr = __atomic_load_n(&MaxLatencyUs, __ATOMIC_RELAXED);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reset all the statistics to zero.
+ */
+//--------------------------------------------------------------------------------------------------
+void stats_Reset
+(
+    void
+)
+{
+    for (int i = 0; i < STATS_NUM_CALLS; i++)
+    {
+        __atomic_store_n(&Calls[i].calls, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&Calls[i].failures, 0, __ATOMIC_RELAXED);
+    }
+    for (int i = 0; i < PIN_COUNT; i++)
+    {
+        __atomic_store_n(&Pins[i].writes, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&Pins[i].failures, 0, __ATOMIC_RELAXED);
+    }
+    for (int i = 0; i < MANGOH_MUXCTRL_NUM_LATENCY_BUCKETS; i++)
+    {
+        __atomic_store_n(&LatencyBuckets[i], 0, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&MaxLatencyUs, 0, __ATOMIC_RELAXED);
+}
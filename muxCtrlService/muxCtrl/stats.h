@@ -0,0 +1,121 @@
+/**
+ * @file stats.h
+ *
+ * Call, pin and GPIO latency statistics of the mux control service.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#ifndef MUXCTRL_STATS_H_INCLUDE_GUARD
+#define MUXCTRL_STATS_H_INCLUDE_GUARD
+
+#include "pinState.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * API calls that statistics are kept for.  The single operations are numbered like
+ * mangoh_muxCtrl_Operation_t, and are counted whichever API function ran them.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    STATS_CALL_PULSE_RESET = MANGOH_MUXCTRL_OP_ARDUINO_RESET + 1,
+    STATS_CALL_APPLY_CONFIGURATION,
+    STATS_CALL_EXECUTE_SEQUENCE,
+    STATS_NUM_CALLS
+}
+stats_Call_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a time stamp to pass to stats_RecordGpioCall(): the CLOCK_MONOTONIC time in nanoseconds.
+ */
+//--------------------------------------------------------------------------------------------------
+uint64_t stats_GetTimeStamp
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Record the result of an API call.  May be called from any thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void stats_RecordCall
+(
+    uint32_t call,          ///< stats_Call_t or mangoh_muxCtrl_Operation_t
+    le_result_t result      ///< Result of the call
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Record a call to the GPIO backend that wrote some pins.  May be called from any thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void stats_RecordGpioCall
+(
+    uint32_t pinMask,       ///< Pins written (bit n is pinState_Pin_t n)
+    le_result_t result,     ///< Result of the backend call
+    uint64_t startTime      ///< Time stamp taken before the call by stats_GetTimeStamp()
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the statistics of an API call.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_OUT_OF_RANGE if there is no call with that index
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t stats_GetCall
+(
+    uint32_t call,              ///< Index of the call
+    const char** namePtr,       ///< [OUT] Name of the API function
+    uint32_t* callsPtr,         ///< [OUT] Number of calls
+    uint32_t* failuresPtr       ///< [OUT] Number of calls that failed
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the statistics of a pin.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_OUT_OF_RANGE if there is no pin with that index
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t stats_GetPin
+(
+    uint32_t pin,               ///< Index of the pin
+    const char** namePtr,       ///< [OUT] Name of the pin
+    uint32_t* writesPtr,        ///< [OUT] Number of GPIO calls that wrote the pin
+    uint32_t* failuresPtr       ///< [OUT] Number of those calls that failed
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the latency histogram of the GPIO backend calls.  Bucket 0 counts calls that took less than
+ * 1 microsecond, bucket n calls that took from 2^(n-1) up to 2^n microseconds, and the last bucket
+ * every longer call.
+ */
+//--------------------------------------------------------------------------------------------------
+void stats_GetGpioLatency
+(
+    uint32_t* bucketsPtr,       ///< [OUT] MANGOH_MUXCTRL_NUM_LATENCY_BUCKETS buckets
+    uint32_t* maxUsPtr          ///< [OUT] Longest call, in microseconds
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reset all the statistics to zero.
+ */
+//--------------------------------------------------------------------------------------------------
+void stats_Reset
+(
+    void
+);
+
+#endif // MUXCTRL_STATS_H_INCLUDE_GUARD
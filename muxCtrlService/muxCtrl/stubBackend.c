@@ -0,0 +1,123 @@
+/**
+ * @file stubBackend.c
+ *
+ * Backend that drives a local stand-in for the GPIO expanders instead of real hardware.  Each
+ * expander is modelled as a single output register, and every call to write() is one register
+ * write, so the number of expander writes made for an operation (see GetExpanderWriteCount()) can
+ * be checked without a mangOH board.
+ *
+ * Pin values are stored as logical (active/inactive) values; polarity is not modelled.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "backend.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Output register of each stand-in expander, indexed by expander number.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint16_t OutputRegister[PIN_STATE_MAX_EXPANDER + 1];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pins that have been configured as outputs, as a bit mask of pinState_Pin_t values.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t ConfiguredPins;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Configure a pin as an output with the given initial value.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Configure
+(
+    pinState_Pin_t pin,
+    bool value
+)
+{
+    uint16_t bit = 1 << pinState_GetExpanderPin(pin);
+
+    if (value)
+    {
+        OutputRegister[pinState_GetExpander(pin)] |= bit;
+    }
+    else
+    {
+        OutputRegister[pinState_GetExpander(pin)] &= ~bit;
+    }
+    ConfiguredPins |= (1 << pin);
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read back the state of a pin from its stand-in output register.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Read
+(
+    pinState_Pin_t pin,
+    bool* activePtr
+)
+{
+    if ((ConfiguredPins & (1 << pin)) == 0)
+    {
+        return LE_UNAVAILABLE;
+    }
+
+    *activePtr = ((OutputRegister[pinState_GetExpander(pin)] &
+                   (1 << pinState_GetExpanderPin(pin))) != 0);
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write a group of pins on one expander as a single register write.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Write
+(
+    uint8_t expander,
+    uint32_t pinMask,
+    uint32_t pinValues,
+    const pinState_Pin_t* pinOrderPtr
+)
+{
+    uint16_t regMask;
+    uint16_t regValues;
+
+    backend_ToRegister(expander, pinMask, pinValues, &regMask, &regValues);
+
+    OutputRegister[expander] = (OutputRegister[expander] & ~regMask) | regValues;
+
+    LE_DEBUG("Stand-in expander %u output register = 0x%04x", expander, OutputRegister[expander]);
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Backend that drives a local stand-in for the expanders.
+ */
+//--------------------------------------------------------------------------------------------------
+const backend_Ops_t backend_Stub =
+{
+    .name = "stub",
+    .init = NULL,
+    .configure = Configure,
+    .read = Read,
+    .write = Write,
+};
@@ -0,0 +1,144 @@
+/**
+ * @file trace.c
+ *
+ * Ring buffer of time-stamped pin writes, for correlating mux switches with what clients see.
+ *
+ * The ring is lock-free.  A writer claims the next sequence number with an atomic increment and
+ * fills in the slot it maps to.  Each slot has a guard that holds 0 while the slot is being
+ * written and the sequence number of its entry once it is complete.  A reader copies a slot and
+ * keeps the copy only if the guard holds the expected sequence number both before and after.
+ * Entries that were overwritten while being read are skipped.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "pinState.h"
+#include "trace.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of entries in the ring.  Must be a power of two.
+ */
+//--------------------------------------------------------------------------------------------------
+#define TRACE_SIZE 1024
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * A slot of the ring.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint32_t guard;         ///< 0 while being written, otherwise the sequence number of entry
+    trace_Entry_t entry;
+}
+Slot_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The ring.
+ */
+//--------------------------------------------------------------------------------------------------
+static Slot_t Ring[TRACE_SIZE];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sequence number of the last entry claimed by a writer.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t LastSeq;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Record a pin write.  Lock-free; may be called from any thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void trace_Record
+(
+    uint64_t timeNs,        ///< CLOCK_MONOTONIC time of the write, in nanoseconds
+    int32_t client,         ///< Process ID of the client, or 0 for the service itself
+    uint32_t call,          ///< API call, or PIN_STATE_NO_CALL
+    pinState_Pin_t pin,     ///< Pin written
+    bool value,             ///< Value written
+    le_result_t result      ///< Result of the write
+)
+{
+    uint32_t seq = __atomic_add_fetch(&LastSeq, 1, __ATOMIC_RELAXED);
+    if (seq == 0)
+    {
+        // 0 marks a slot that is being written, so skip it when the counter wraps.
+        seq = __atomic_add_fetch(&LastSeq, 1, __ATOMIC_RELAXED);
+    }
+
+    Slot_t* slotPtr = &Ring[seq & (TRACE_SIZE - 1)];
+
+    __atomic_store_n(&slotPtr->guard, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    slotPtr->entry.seq = seq;
+    slotPtr->entry.timeNs = timeNs;
+    slotPtr->entry.client = client;
+    slotPtr->entry.call = call;
+    slotPtr->entry.pin = pin;
+    slotPtr->entry.value = value;
+    slotPtr->entry.result = result;
+
+    __atomic_store_n(&slotPtr->guard, seq, __ATOMIC_RELEASE);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Copy entries out of the trace, oldest first, starting with the entry with sequence number
+ * startSeq or, if that entry has already been overwritten, the oldest one still in the trace.
+ *
+ * @return
+ *      Number of entries copied
+ */
+//--------------------------------------------------------------------------------------------------
+size_t trace_Read
+(
+    uint32_t startSeq,          ///< Sequence number of the first entry wanted
+    trace_Entry_t* entriesPtr,  ///< [OUT] Entries
+    size_t maxEntries           ///< Number of entries that fit in entriesPtr
+)
+{
+    uint32_t lastSeq = __atomic_load_n(&LastSeq, __ATOMIC_ACQUIRE);
+    size_t count = 0;
+
+    if ((int32_t)(lastSeq - startSeq) >= TRACE_SIZE)
+    {
+        startSeq = lastSeq - TRACE_SIZE + 1;
+    }
+    if (startSeq == 0)
+    {
+        startSeq = 1;
+    }
+
+    for (uint32_t seq = startSeq; ((int32_t)(lastSeq - seq) >= 0) && (count < maxEntries); seq++)
+    {
+        Slot_t* slotPtr = &Ring[seq & (TRACE_SIZE - 1)];
+
+        if (__atomic_load_n(&slotPtr->guard, __ATOMIC_ACQUIRE) != seq)
+        {
+            continue;
+        }
+
+        entriesPtr[count] = slotPtr->entry;
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slotPtr->guard, __ATOMIC_RELAXED) == seq)
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file trace.h
+ *
+ * Ring buffer of time-stamped pin writes, for correlating mux switches with what clients see.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#ifndef MUXCTRL_TRACE_H_INCLUDE_GUARD
+#define MUXCTRL_TRACE_H_INCLUDE_GUARD
+
+#include "pinState.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * A pin write recorded in the trace.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint32_t seq;           ///< Sequence number of the entry, counting from 1
+    uint64_t timeNs;        ///< CLOCK_MONOTONIC time of the write, in nanoseconds
+    int32_t client;         ///< Process ID of the client, or 0 for the service itself
+    uint32_t call;          ///< API call (stats_Call_t), or PIN_STATE_NO_CALL
+    uint8_t pin;            ///< Pin written (pinState_Pin_t)
+    bool value;             ///< Value written
+    le_result_t result;     ///< Result of the write
+}
+trace_Entry_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Record a pin write.  Lock-free; may be called from any thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void trace_Record
+(
+    uint64_t timeNs,        ///< CLOCK_MONOTONIC time of the write, in nanoseconds
+    int32_t client,         ///< Process ID of the client, or 0 for the service itself
+    uint32_t call,          ///< API call, or PIN_STATE_NO_CALL
+    pinState_Pin_t pin,     ///< Pin written
+    bool value,             ///< Value written
+    le_result_t result      ///< Result of the write
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Copy entries out of the trace, oldest first, starting with the entry with sequence number
+ * startSeq or, if that entry has already been overwritten, the oldest one still in the trace.
+ *
+ * @return
+ *      Number of entries copied
+ */
+//--------------------------------------------------------------------------------------------------
+size_t trace_Read
+(
+    uint32_t startSeq,          ///< Sequence number of the first entry wanted
+    trace_Entry_t* entriesPtr,  ///< [OUT] Entries
+    size_t maxEntries           ///< Number of entries that fit in entriesPtr
+);
+
+#endif // MUXCTRL_TRACE_H_INCLUDE_GUARD
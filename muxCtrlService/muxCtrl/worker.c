@@ -0,0 +1,179 @@
+/**
+ * @file worker.c
+ *
+ * Thread that makes all the calls to the backend, so that the main thread can keep handling IPC
+ * messages while an expander write is in progress.
+ *
+ * The backend's IPC sessions belong to the worker thread, so the backend is also initialized on
+ * it.  The main thread hands transitions over with le_event_QueueFunctionToThread() and gets the
+ * result back the same way.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+#include "worker.h"
+#include "muxState.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * A transition handed over to the worker thread.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    pinState_Transition_t transition;   ///< Transition to commit
+    worker_DoneFunc_t doneFunc;         ///< Function to call on the main thread when done
+    void* contextPtr;                   ///< Passed to doneFunc
+    le_result_t result;                 ///< Result of the commit
+}
+Job_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pool of Job_t.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t JobPool;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The main (IPC) thread and the worker thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_thread_Ref_t MainThread;
+static le_thread_Ref_t WorkerThread;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Posted by the worker thread once the pins are configured.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_sem_Ref_t ReadySem;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start states handed to pinState_Init() on the worker thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static const pinState_Transition_t* StartPtr;
+static bool WarmStart;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Report the result of a job.  Runs on the main thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static void JobDone
+(
+    void* param1Ptr,  ///< Job_t
+    void* param2Ptr   ///< Not used
+)
+{
+    Job_t* jobPtr = param1Ptr;
+
+    // Clients watching the state hear about a change before the requester gets its result.
+    muxState_Update();
+
+    jobPtr->doneFunc(jobPtr->result, jobPtr->contextPtr);
+    le_mem_Release(jobPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Commit the transition of a job.  Runs on the worker thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RunJob
+(
+    void* param1Ptr,  ///< Job_t
+    void* param2Ptr   ///< Not used
+)
+{
+    Job_t* jobPtr = param1Ptr;
+
+    jobPtr->result = pinState_CommitTransition(&jobPtr->transition);
+    le_event_QueueFunctionToThread(MainThread, JobDone, jobPtr, NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Main function of the worker thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static void* WorkerMain
+(
+    void* contextPtr  ///< Not used
+)
+{
+    pinState_Init(StartPtr, WarmStart);
+    le_sem_Post(ReadySem);
+
+    le_event_RunLoop();
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the worker thread and wait for it to configure the pins (see pinState_Init()).  Must be
+ * called on the main thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void worker_Init
+(
+    const pinState_Transition_t* startPtr, ///< Start states of some pins, or NULL for none
+    bool warmStart                         ///< true if the service is restarting
+)
+{
+    StartPtr = startPtr;
+    WarmStart = warmStart;
+    MainThread = le_thread_GetCurrent();
+    JobPool = le_mem_CreatePool("GPIO jobs", sizeof(Job_t));
+    ReadySem = le_sem_Create("GPIO worker ready", 0);
+
+    WorkerThread = le_thread_Create("GPIO worker", WorkerMain, NULL);
+    le_thread_Start(WorkerThread);
+
+    le_sem_Wait(ReadySem);
+    StartPtr = NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Commit a transition.  If every pin in the transition is already in the requested state, it is
+ * committed straight away on the calling thread; otherwise it is committed on the worker thread.
+ * Either way, doneFunc is called on the main thread once it is done.
+ */
+//--------------------------------------------------------------------------------------------------
+void worker_Commit
+(
+    const pinState_Transition_t* transitionPtr,  ///< Transition to commit (copied)
+    worker_DoneFunc_t doneFunc,                  ///< Function to call when it is committed
+    void* contextPtr                             ///< Passed to doneFunc
+)
+{
+    Job_t* jobPtr = le_mem_ForceAlloc(JobPool);
+
+    jobPtr->transition = *transitionPtr;
+    jobPtr->doneFunc = doneFunc;
+    jobPtr->contextPtr = contextPtr;
+
+    if (pinState_IsUnchanged(transitionPtr))
+    {
+        // Nothing to write, so there is no need to bother the worker thread.
+        jobPtr->result = pinState_CommitTransition(&jobPtr->transition);
+        JobDone(jobPtr, NULL);
+    }
+    else
+    {
+        le_event_QueueFunctionToThread(WorkerThread, RunJob, jobPtr, NULL);
+    }
+}
@@ -0,0 +1,54 @@
+/**
+ * @file worker.h
+ *
+ * Thread that makes all the calls to the backend, so that the main thread can keep handling IPC
+ * messages while an expander write is in progress.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#ifndef MUXCTRL_WORKER_H_INCLUDE_GUARD
+#define MUXCTRL_WORKER_H_INCLUDE_GUARD
+
+#include "pinState.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Function called on the main thread when a transition has been committed.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*worker_DoneFunc_t)
+(
+    le_result_t result,  ///< Result of pinState_CommitTransition()
+    void* contextPtr     ///< Context pointer passed to worker_Commit()
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the worker thread and wait for it to configure the pins (see pinState_Init()).  Must be
+ * called on the main thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void worker_Init
+(
+    const pinState_Transition_t* startPtr, ///< Start states of some pins, or NULL for none
+    bool warmStart                         ///< true if the service is restarting
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Commit a transition.  If every pin in the transition is already in the requested state, it is
+ * committed straight away on the calling thread; otherwise it is committed on the worker thread.
+ * Either way, doneFunc is called on the main thread once it is done.
+ */
+//--------------------------------------------------------------------------------------------------
+void worker_Commit
+(
+    const pinState_Transition_t* transitionPtr,  ///< Transition to commit (copied)
+    worker_DoneFunc_t doneFunc,                  ///< Function to call when it is committed
+    void* contextPtr                             ///< Passed to doneFunc
+);
+
+#endif // MUXCTRL_WORKER_H_INCLUDE_GUARD
@@ -0,0 +1,162 @@
+/**
+ * @file muxStatePage.c
+ *
+ * Reader side of the shared-memory state page published by muxCtrlService.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "muxStatePage.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of times muxStatePage_Read() tries to copy the page before giving up.  The service
+ * updates the page once per transition, so a reader practically never needs more than two.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_READ_ATTEMPTS 100
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The mapped page, or NULL if it is not mapped.
+ */
+//--------------------------------------------------------------------------------------------------
+static const muxStatePage_Layout_t* PagePtr;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Map the page read-only.  Does nothing if it is already mapped.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_UNAVAILABLE if muxCtrlService has not created the page
+ *      - LE_FORMAT_ERROR if the page is too short or has an unknown layout
+ *      - LE_FAULT
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t muxStatePage_Open
+(
+    void
+)
+{
+    if (PagePtr != NULL)
+    {
+        return LE_OK;
+    }
+
+    int fd = shm_open(MUX_STATE_PAGE_NAME, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return (errno == ENOENT) ? LE_UNAVAILABLE : LE_FAULT;
+    }
+
+    // A page that is too short (e.g. the service stopped between creating and sizing it) would
+    // fault on the first read through the mapping.
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        LE_ERROR("Failed to get the size of the mux state page (%m)");
+        close(fd);
+        return LE_FAULT;
+    }
+    if (st.st_size < (off_t)sizeof(muxStatePage_Layout_t))
+    {
+        LE_ERROR("Mux state page is too short (%lld bytes)", (long long)st.st_size);
+        close(fd);
+        return LE_FORMAT_ERROR;
+    }
+
+    void* mapPtr = mmap(NULL, sizeof(muxStatePage_Layout_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapPtr == MAP_FAILED)
+    {
+        LE_ERROR("Failed to map the mux state page (%m)");
+        return LE_FAULT;
+    }
+
+    const muxStatePage_Layout_t* layoutPtr = mapPtr;
+    if ((layoutPtr->magic != MUX_STATE_PAGE_MAGIC) ||
+        (layoutPtr->version != MUX_STATE_PAGE_VERSION))
+    {
+        LE_ERROR("Mux state page has an unknown layout (magic 0x%08x, version %u)",
+                 layoutPtr->magic, layoutPtr->version);
+        munmap(mapPtr, sizeof(muxStatePage_Layout_t));
+        return LE_FORMAT_ERROR;
+    }
+
+    PagePtr = layoutPtr;
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Take a consistent snapshot of the page.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_UNAVAILABLE if the page is not mapped
+ *      - LE_BUSY if the service kept updating the page while it was being copied; try again
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t muxStatePage_Read
+(
+    muxStatePage_Snapshot_t* snapshotPtr  ///< [OUT] Snapshot
+)
+{
+    if (PagePtr == NULL)
+    {
+        return LE_UNAVAILABLE;
+    }
+
+    for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++)
+    {
+        uint32_t before = __atomic_load_n(&PagePtr->sequence, __ATOMIC_ACQUIRE);
+        if (before & 1)
+        {
+            // The service is in the middle of an update.
+            continue;
+        }
+
+        memcpy(snapshotPtr, (const void*)&PagePtr->snapshot, sizeof(*snapshotPtr));
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&PagePtr->sequence, __ATOMIC_RELAXED) == before)
+        {
+            return LE_OK;
+        }
+    }
+
+    return LE_BUSY;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Unmap the page.
+ */
+//--------------------------------------------------------------------------------------------------
+void muxStatePage_Close
+(
+    void
+)
+{
+    if (PagePtr != NULL)
+    {
+        munmap((void*)PagePtr, sizeof(muxStatePage_Layout_t));
+        PagePtr = NULL;
+    }
+}
+
+COMPONENT_INIT
+{
+}
@@ -0,0 +1,115 @@
+/**
+ * @file muxStatePage.h
+ *
+ * Layout of the shared-memory page in which muxCtrlService publishes the position of each mux and
+ * reset line, and the reader functions that take a consistent snapshot of it without any IPC.
+ *
+ * The page is protected by a sequence lock.  The service makes the sequence number odd before it
+ * changes the page and even again afterwards; a reader copies the page and retries if the
+ * sequence number was odd or changed while it was copying.  Readers never block the service.
+ *
+ * To use the reader, add this component to an executable and call muxStatePage_Open() once.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+#ifndef MUXSTATEPAGE_H_INCLUDE_GUARD
+#define MUXSTATEPAGE_H_INCLUDE_GUARD
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Name of the POSIX shared-memory object that holds the page.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MUX_STATE_PAGE_NAME "/mangoh_muxCtrl_state"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Magic number and layout version at the start of the page.  The version changes whenever the
+ * layout does.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MUX_STATE_PAGE_MAGIC   0x4d555853  // "MUXS"
+#define MUX_STATE_PAGE_VERSION 1
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of entries in the positions array.  This matches the number of values of the MuxGroup
+ * enum in mangoh_muxCtrl.api, which is also the index into the array.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MUX_STATE_PAGE_NUM_GROUPS 9
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * State published by the service.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    int32_t positions[MUX_STATE_PAGE_NUM_GROUPS];   ///< Position of each MuxGroup, or -1 if not
+                                                    ///  known; see MuxGroup for what it means
+    uint32_t knownMask;     ///< Pins whose state is known, as a bit mask of pin numbers
+    uint32_t activeMask;    ///< Pins that are active (only meaningful if known)
+    uint32_t updateCount;   ///< Incremented each time the service updates the page
+}
+muxStatePage_Snapshot_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Layout of the page.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint32_t magic;                     ///< MUX_STATE_PAGE_MAGIC
+    uint32_t version;                   ///< MUX_STATE_PAGE_VERSION
+    uint32_t sequence;                  ///< Odd while the service is updating the snapshot
+    muxStatePage_Snapshot_t snapshot;   ///< Published state
+}
+muxStatePage_Layout_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Map the page read-only.  Does nothing if it is already mapped.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_UNAVAILABLE if muxCtrlService has not created the page
+ *      - LE_FORMAT_ERROR if the page is too short or has an unknown layout
+ *      - LE_FAULT
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t muxStatePage_Open
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Take a consistent snapshot of the page.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_UNAVAILABLE if the page is not mapped
+ *      - LE_BUSY if the service kept updating the page while it was being copied; try again
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t muxStatePage_Read
+(
+    muxStatePage_Snapshot_t* snapshotPtr  ///< [OUT] Snapshot
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Unmap the page.
+ */
+//--------------------------------------------------------------------------------------------------
+void muxStatePage_Close
+(
+    void
+);
+
+#endif // MUXSTATEPAGE_H_INCLUDE_GUARD
@@ -0,0 +1,154 @@
+/**
+ * @file
+ *
+ * Checks the number of I2C bus transactions the mux control service makes for each operation with
+ * the i2c backend: one block write and one block read to verify it for each expander the
+ * operation changes pins on, and none for an operation that changes nothing.
+ *
+ * Run it against the service with MUXCTRL_BACKEND=i2c on the kernel's i2c-stub module, e.g. with
+ * test/i2cStubTest.sh.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Bus transactions per expander write (see i2cBackend.c).
+ */
+//--------------------------------------------------------------------------------------------------
+#define TRANSACTIONS_PER_WRITE 2
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Operations to check, the operation run first to move their mux somewhere else, and the number
+ * of expanders that the pins each operation changes after its setup are on (see pinState.c).
+ */
+//--------------------------------------------------------------------------------------------------
+static const struct
+{
+    const char* name;
+    le_result_t (*setup)(void);
+    le_result_t (*function)(void);
+    uint32_t expanders;
+}
+Operations[] =
+{
+    {
+        .name = "Iot0Uart1On",
+        .setup = mangoh_muxCtrl_Iot1Uart1On,
+        .function = mangoh_muxCtrl_Iot0Uart1On,
+        .expanders = 1
+    },
+    {
+        .name = "IotAllUart1Off",
+        .setup = mangoh_muxCtrl_Iot0Uart1On,
+        .function = mangoh_muxCtrl_IotAllUart1Off,
+        .expanders = 1
+    },
+    {
+        .name = "Iot1Spi1On",
+        .setup = mangoh_muxCtrl_Iot0Spi1On,
+        .function = mangoh_muxCtrl_Iot1Spi1On,
+        .expanders = 1
+    },
+    {
+        .name = "Iot2Uart2On",
+        .setup = mangoh_muxCtrl_Uart2DebugOn,
+        .function = mangoh_muxCtrl_Iot2Uart2On,
+        .expanders = 1
+    },
+    {
+        .name = "SdioSelIot0",
+        .setup = mangoh_muxCtrl_SdioSelMicroSd,
+        .function = mangoh_muxCtrl_SdioSelIot0,
+        .expanders = 1
+    },
+    {
+        .name = "AudioSelectIot0Codec",
+        .setup = mangoh_muxCtrl_AudioSelectInternalCodec,
+        .function = mangoh_muxCtrl_AudioSelectIot0Codec,
+        .expanders = 2
+    },
+    {
+        .name = "AudioDisable",
+        .setup = mangoh_muxCtrl_AudioSelectOnboardCodec,
+        .function = mangoh_muxCtrl_AudioDisable,
+        .expanders = 1
+    },
+    {
+        .name = "ArduinoAssertReset",
+        .setup = mangoh_muxCtrl_ArduinoDeassertReset,
+        .function = mangoh_muxCtrl_ArduinoAssertReset,
+        .expanders = 1
+    },
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run an operation and get the number of bus transactions it made.
+ *
+ * @return
+ *      The result of the operation, or LE_FAULT if the transactions can't be counted.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CountTransactions
+(
+    le_result_t (*function)(void),  ///< Operation to run
+    uint32_t* countPtr              ///< [OUT] Number of bus transactions it made
+)
+{
+    uint32_t before;
+    uint32_t after;
+
+    if (mangoh_muxCtrl_GetBusTransactionCount(&before) != LE_OK)
+    {
+        return LE_FAULT;
+    }
+
+    le_result_t result = function();
+
+    if (mangoh_muxCtrl_GetBusTransactionCount(&after) != LE_OK)
+    {
+        return LE_FAULT;
+    }
+
+    *countPtr = after - before;
+
+    return result;
+}
+
+COMPONENT_INIT
+{
+    uint32_t count;
+
+    LE_TEST_PLAN(3 * NUM_ARRAY_MEMBERS(Operations) + 1);
+
+    LE_TEST_OK(mangoh_muxCtrl_GetBusTransactionCount(&count) == LE_OK,
+               "the backend counts bus transactions");
+
+    // Don't let a coalescing window delay or merge the requests being counted.
+    mangoh_muxCtrl_SetCoalescingWindow(0);
+
+    for (int i = 0; i < NUM_ARRAY_MEMBERS(Operations); i++)
+    {
+        LE_TEST_OK(Operations[i].setup() == LE_OK, "set up %s", Operations[i].name);
+
+        uint32_t expected = TRANSACTIONS_PER_WRITE * Operations[i].expanders;
+        le_result_t result = CountTransactions(Operations[i].function, &count);
+        LE_TEST_OK((result == LE_OK) && (count == expected),
+                   "%s makes %u bus transactions (%u expected)",
+                   Operations[i].name, count, expected);
+
+        result = CountTransactions(Operations[i].function, &count);
+        LE_TEST_OK((result == LE_OK) && (count == 0),
+                   "%s again makes %u bus transactions (0 expected)", Operations[i].name, count);
+    }
+
+    LE_TEST_EXIT;
+}
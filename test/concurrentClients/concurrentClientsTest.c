@@ -0,0 +1,261 @@
+/**
+ * @file
+ *
+ * Measures the latency the mux control service gives many clients at once: several clients, each
+ * with its own session on its own thread, switch muxes back and forth while another keeps
+ * querying the pin cache.  Every call's round trip is timed and the percentiles are printed.  The
+ * test checks that a query is answered in well under the time a switch takes on its own, i.e. that
+ * it doesn't wait behind the expander writes of the switches in progress.
+ *
+ * Run it against the service with the real expanders, e.g. with test/concurrentClientsTest.sh; a
+ * stand-in backend that writes instantly has no write latency for the queries to wait behind.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of clients switching muxes, and the number of switches each makes.
+ */
+//--------------------------------------------------------------------------------------------------
+#define NUM_WRITERS 8
+#define SWITCHES_PER_WRITER 50
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Most queries the querying client makes while the switches run, and the pause between them.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_QUERIES 4096
+#define QUERY_INTERVAL_US 1000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pairs of operations the writers switch between; writer i uses pair i modulo the number of
+ * pairs, so several writers contend for each mux.
+ */
+//--------------------------------------------------------------------------------------------------
+static const struct
+{
+    le_result_t (*first)(void);
+    le_result_t (*second)(void);
+}
+Switches[] =
+{
+    { mangoh_muxCtrl_Iot0Uart1On, mangoh_muxCtrl_Iot1Uart1On },
+    { mangoh_muxCtrl_Iot0Spi1On, mangoh_muxCtrl_Iot1Spi1On },
+    { mangoh_muxCtrl_Iot2Uart2On, mangoh_muxCtrl_Uart2DebugOn },
+    { mangoh_muxCtrl_SdioSelMicroSd, mangoh_muxCtrl_SdioSelIot0 },
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Round trip of each switch made alone, each switch made by the writers and each query, in
+ * microseconds, and the number of switches that failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t AloneUs[SWITCHES_PER_WRITER];
+static uint32_t SwitchUs[NUM_WRITERS * SWITCHES_PER_WRITER];
+static uint32_t QueryUs[MAX_QUERIES];
+static size_t NumQueries;
+static int SwitchFailures;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set once every writer has finished.
+ */
+//--------------------------------------------------------------------------------------------------
+static volatile bool WritersDone;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the time elapsed since a relative time, in microseconds.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t ElapsedUs
+(
+    le_clk_Time_t startTime
+)
+{
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), startTime);
+
+    return (uint32_t)(elapsed.sec * 1000000 + elapsed.usec);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Switch a mux back and forth SWITCHES_PER_WRITER times, timing each switch.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TimeSwitches
+(
+    int pair,               ///< Index in Switches of the operations to switch between
+    uint32_t* latenciesPtr  ///< [OUT] Round trip of each switch
+)
+{
+    for (int i = 0; i < SWITCHES_PER_WRITER; i++)
+    {
+        le_clk_Time_t startTime = le_clk_GetRelativeTime();
+        le_result_t result = (i % 2 == 0) ? Switches[pair].first() : Switches[pair].second();
+
+        latenciesPtr[i] = ElapsedUs(startTime);
+        if (result != LE_OK)
+        {
+            __atomic_add_fetch(&SwitchFailures, 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Switch a mux back and forth.  Runs on its own thread, with its own session.
+ */
+//--------------------------------------------------------------------------------------------------
+static void* WriterMain
+(
+    void* contextPtr    ///< Index of the writer
+)
+{
+    int writer = (intptr_t)contextPtr;
+
+    mangoh_muxCtrl_ConnectService();
+    TimeSwitches(writer % NUM_ARRAY_MEMBERS(Switches), &SwitchUs[writer * SWITCHES_PER_WRITER]);
+    mangoh_muxCtrl_DisconnectService();
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Query the pin cache until the writers have finished, timing each query.  Runs on its own
+ * thread, with its own session.
+ */
+//--------------------------------------------------------------------------------------------------
+static void* QuerierMain
+(
+    void* contextPtr
+)
+{
+    mangoh_muxCtrl_ConnectService();
+
+    while (!WritersDone && (NumQueries < MAX_QUERIES))
+    {
+        uint32_t hits;
+        uint32_t misses;
+        le_clk_Time_t startTime = le_clk_GetRelativeTime();
+
+        mangoh_muxCtrl_GetPinCacheStats(&hits, &misses);
+        QueryUs[NumQueries++] = ElapsedUs(startTime);
+        usleep(QUERY_INTERVAL_US);
+    }
+
+    mangoh_muxCtrl_DisconnectService();
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start a client thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_thread_Ref_t StartClient
+(
+    const char* namePtr,
+    le_thread_MainFunc_t mainFunc,
+    void* contextPtr
+)
+{
+    le_thread_Ref_t threadRef = le_thread_Create(namePtr, mainFunc, contextPtr);
+
+    le_thread_SetJoinable(threadRef);
+    le_thread_Start(threadRef);
+
+    return threadRef;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compare two latencies, for qsort().
+ */
+//--------------------------------------------------------------------------------------------------
+static int CompareUs
+(
+    const void* aPtr,
+    const void* bPtr
+)
+{
+    uint32_t a = *(const uint32_t*)aPtr;
+    uint32_t b = *(const uint32_t*)bPtr;
+
+    return (a > b) - (a < b);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sort a set of latencies and print their percentiles.
+ *
+ * @return
+ *      The median
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t Report
+(
+    const char* namePtr,
+    uint32_t* latenciesPtr,
+    size_t count
+)
+{
+    qsort(latenciesPtr, count, sizeof(latenciesPtr[0]), CompareUs);
+
+    LE_TEST_INFO("%s: %zu calls, p50 %u us, p90 %u us, p99 %u us, max %u us", namePtr, count,
+                 latenciesPtr[count / 2], latenciesPtr[count * 9 / 10],
+                 latenciesPtr[count * 99 / 100], latenciesPtr[count - 1]);
+
+    return latenciesPtr[count / 2];
+}
+
+COMPONENT_INIT
+{
+    le_thread_Ref_t writers[NUM_WRITERS];
+
+    LE_TEST_PLAN(4);
+
+    TimeSwitches(0, AloneUs);
+    LE_TEST_OK(SwitchFailures == 0, "one client switches a mux (%d failures)", SwitchFailures);
+    uint32_t aloneMedianUs = Report("switch alone", AloneUs, NUM_ARRAY_MEMBERS(AloneUs));
+
+    le_thread_Ref_t querier = StartClient("Querier", QuerierMain, NULL);
+    for (int i = 0; i < NUM_WRITERS; i++)
+    {
+        char name[16];
+        snprintf(name, sizeof(name), "Writer%d", i);
+        writers[i] = StartClient(name, WriterMain, (void*)(intptr_t)i);
+    }
+
+    for (int i = 0; i < NUM_WRITERS; i++)
+    {
+        le_thread_Join(writers[i], NULL);
+    }
+    WritersDone = true;
+    le_thread_Join(querier, NULL);
+
+    LE_TEST_OK(SwitchFailures == 0, "%d clients switch muxes at once (%d failures)", NUM_WRITERS,
+               SwitchFailures);
+    LE_TEST_OK(NumQueries > 0, "another client queries meanwhile (%zu queries)", NumQueries);
+
+    Report("switch", SwitchUs, NUM_ARRAY_MEMBERS(SwitchUs));
+    uint32_t queryMedianUs = (NumQueries > 0) ? Report("query", QueryUs, NumQueries) : UINT32_MAX;
+
+    LE_TEST_OK(queryMedianUs < aloneMedianUs / 2,
+               "a query doesn't wait behind the switches (median %u us, switch alone %u us)",
+               queryMedianUs, aloneMedianUs);
+
+    LE_TEST_EXIT;
+}
@@ -0,0 +1,9 @@
+#!/bin/sh
+# Measures the latency of many clients using the service at once, with the real expanders.
+#
+# Usage: concurrentClientsTest.sh
+
+. "$(dirname "$0")/testLib.sh"
+
+RestartService
+RunTest concurrentClientsTest
@@ -0,0 +1,42 @@
+#!/bin/sh
+# Checks the line levels each mux operation drives, using the cdev backend with gpio-sim chips
+# standing in for expanders 1 and 3.  Needs a kernel with gpio-sim (5.17 or later) and configfs
+# mounted on /sys/kernel/config.
+#
+# Usage: gpioSimTest.sh
+
+. "$(dirname "$0")/testLib.sh"
+
+SIM=/sys/kernel/config/gpio-sim/muxCtrlTest
+EXPANDERS="1 3"
+
+# Cleanup: remove the simulated chips once the service has let go of them.
+Cleanup()
+{
+    [ -d "$SIM" ] || return
+    echo 0 > "$SIM/live"
+    for n in $EXPANDERS; do
+        rmdir "$SIM/bank$n"
+    done
+    rmdir "$SIM"
+}
+
+modprobe gpio-sim || exit 1
+mkdir "$SIM" || exit 1
+for n in $EXPANDERS; do
+    mkdir "$SIM/bank$n" || exit 1
+    echo 16 > "$SIM/bank$n/num_lines" || exit 1
+done
+echo 1 > "$SIM/live" || exit 1
+
+DEV_NAME=$(cat "$SIM/dev_name")
+for n in $EXPANDERS; do
+    CHIP=$(cat "$SIM/bank$n/chip_name")
+    SetServiceEnv "MUXCTRL_GPIOCHIP_$n" "/dev/$CHIP"
+    AddServiceDevice "/dev/$CHIP"
+    SetTestEnv lineValueTest "MUXCTRL_TEST_SIM_$n" "/sys/devices/platform/$DEV_NAME/$CHIP"
+done
+
+SetServiceEnv MUXCTRL_BACKEND cdev
+RestartService
+RunTest lineValueTest
@@ -0,0 +1,37 @@
+#!/bin/sh
+# Checks the number of I2C bus transactions each mux operation makes, using the i2c backend with
+# the kernel's i2c-stub module standing in for the expanders.  Needs the i2c-stub and i2c-dev
+# modules, and i2c-stub must not already be loaded.
+#
+# Usage: i2cStubTest.sh
+
+. "$(dirname "$0")/testLib.sh"
+
+# The mangOH Green expander addresses (see i2cBackend.c).
+ADDRESSES=0x3e,0x3f,0x70
+
+# Cleanup: remove the stub adapter once the service has let go of it.
+Cleanup()
+{
+    rmmod i2c-stub
+}
+
+modprobe i2c-dev || exit 1
+modprobe i2c-stub chip_addr=$ADDRESSES || exit 1
+
+BUS=
+for ADAPTER in /sys/class/i2c-adapter/i2c-*; do
+    if [ "$(cat "$ADAPTER/name")" = "SMBus stub driver" ]; then
+        BUS=/dev/$(basename "$ADAPTER")
+    fi
+done
+if [ -z "$BUS" ]; then
+    echo "Can't find the i2c-stub adapter" >&2
+    exit 1
+fi
+
+SetServiceEnv MUXCTRL_BACKEND i2c
+SetServiceEnv MUXCTRL_I2C_BUS "$BUS"
+AddServiceDevice "$BUS"
+RestartService
+RunTest busTransactionTest
@@ -0,0 +1,218 @@
+/**
+ * @file
+ *
+ * Checks the line levels the mux control service drives after each operation, with gpio-sim
+ * chips standing in for the GPIO expanders (MUXCTRL_BACKEND=cdev).
+ *
+ * The sysfs directory of the simulated chip of expander n (e.g.
+ * /sys/devices/platform/gpio-sim.0/gpiochip2) comes from the environment variable
+ * MUXCTRL_TEST_SIM_<n>; test/gpioSimTest.sh creates the chips and sets these up.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The pins, as laid out in pinState.c.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    UART1_ENABLE,
+    UART1_SELECT,
+    SPI_ENABLE,
+    SPI_SELECT,
+    UART2_ENABLE,
+    UART2_SELECT,
+    PCM_ENABLE,
+    PCM_SELECT,
+    SDIO_SELECT,
+    PCM_ANALOG_SELECT,
+    IOT0_RESET,
+    IOT1_RESET,
+    IOT2_RESET,
+    ARDUINO_RESET,
+    PIN_COUNT
+}
+Pin_t;
+
+static const struct
+{
+    const char* name;
+    uint8_t expander;
+    uint8_t expanderPin;
+    bool activeLow;
+}
+Pins[PIN_COUNT] =
+{
+    [UART1_ENABLE]      = { "Uart1Enable",     1, 10, true  },
+    [UART1_SELECT]      = { "Uart1Select",     1, 11, false },
+    [SPI_ENABLE]        = { "SpiEnable",       1, 14, true  },
+    [SPI_SELECT]        = { "SpiSelect",       1, 15, false },
+    [UART2_ENABLE]      = { "Uart2Enable",     3,  8, true  },
+    [UART2_SELECT]      = { "Uart2Select",     1, 12, false },
+    [PCM_ENABLE]        = { "PcmEnable",       3,  9, true  },
+    [PCM_SELECT]        = { "PcmSelect",       3, 10, false },
+    [SDIO_SELECT]       = { "SdioSelect",      1, 13, false },
+    [PCM_ANALOG_SELECT] = { "PcmAnalogSelect", 1,  6, false },
+    [IOT0_RESET]        = { "Iot0Reset",       3,  4, true  },
+    [IOT1_RESET]        = { "Iot1Reset",       3,  3, true  },
+    [IOT2_RESET]        = { "Iot2Reset",       3,  2, true  },
+    [ARDUINO_RESET]     = { "ArduinoReset",    1,  4, true  },
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Most pins an operation sets.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_OPERATION_PINS 3
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Operations to check and the state (active or not) each leaves its pins in (see routing.c).
+ */
+//--------------------------------------------------------------------------------------------------
+static const struct
+{
+    const char* name;
+    le_result_t (*function)(void);
+    size_t pinCount;
+    struct
+    {
+        Pin_t pin;
+        bool active;
+    }
+    pins[MAX_OPERATION_PINS];
+}
+Operations[] =
+{
+    { "Iot0Uart1On", mangoh_muxCtrl_Iot0Uart1On, 2,
+      { { UART1_SELECT, true }, { UART1_ENABLE, true } } },
+    { "Iot1Uart1On", mangoh_muxCtrl_Iot1Uart1On, 2,
+      { { UART1_SELECT, false }, { UART1_ENABLE, true } } },
+    { "IotAllUart1Off", mangoh_muxCtrl_IotAllUart1Off, 1,
+      { { UART1_ENABLE, false } } },
+    { "Iot0Spi1On", mangoh_muxCtrl_Iot0Spi1On, 2,
+      { { SPI_SELECT, true }, { SPI_ENABLE, true } } },
+    { "Iot1Spi1On", mangoh_muxCtrl_Iot1Spi1On, 2,
+      { { SPI_SELECT, false }, { SPI_ENABLE, true } } },
+    { "IotAllSpiOff", mangoh_muxCtrl_IotAllSpiOff, 1,
+      { { SPI_ENABLE, false } } },
+    { "Iot2Uart2On", mangoh_muxCtrl_Iot2Uart2On, 2,
+      { { UART2_SELECT, true }, { UART2_ENABLE, true } } },
+    { "Uart2DebugOn", mangoh_muxCtrl_Uart2DebugOn, 2,
+      { { UART2_SELECT, false }, { UART2_ENABLE, true } } },
+    { "IotAllUart2Off", mangoh_muxCtrl_IotAllUart2Off, 1,
+      { { UART2_ENABLE, false } } },
+    { "SdioSelIot0", mangoh_muxCtrl_SdioSelIot0, 1,
+      { { SDIO_SELECT, false } } },
+    { "SdioSelMicroSd", mangoh_muxCtrl_SdioSelMicroSd, 1,
+      { { SDIO_SELECT, true } } },
+    { "AudioSelectIot0Codec", mangoh_muxCtrl_AudioSelectIot0Codec, 3,
+      { { PCM_SELECT, false }, { PCM_ANALOG_SELECT, false }, { PCM_ENABLE, true } } },
+    { "AudioSelectOnboardCodec", mangoh_muxCtrl_AudioSelectOnboardCodec, 3,
+      { { PCM_SELECT, true }, { PCM_ANALOG_SELECT, false }, { PCM_ENABLE, true } } },
+    { "AudioSelectInternalCodec", mangoh_muxCtrl_AudioSelectInternalCodec, 2,
+      { { PCM_ENABLE, false }, { PCM_ANALOG_SELECT, true } } },
+    { "AudioDisable", mangoh_muxCtrl_AudioDisable, 2,
+      { { PCM_ENABLE, false }, { PCM_ANALOG_SELECT, false } } },
+    { "IotSlot0DeassertReset", mangoh_muxCtrl_IotSlot0DeassertReset, 1,
+      { { IOT0_RESET, false } } },
+    { "IotSlot1DeassertReset", mangoh_muxCtrl_IotSlot1DeassertReset, 1,
+      { { IOT1_RESET, false } } },
+    { "IotSlot2DeassertReset", mangoh_muxCtrl_IotSlot2DeassertReset, 1,
+      { { IOT2_RESET, false } } },
+    { "ArduinoAssertReset", mangoh_muxCtrl_ArduinoAssertReset, 1,
+      { { ARDUINO_RESET, true } } },
+    { "ArduinoDeassertReset", mangoh_muxCtrl_ArduinoDeassertReset, 1,
+      { { ARDUINO_RESET, false } } },
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the level of a pin's simulated line.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_FAULT if the level can't be read
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ReadLevel
+(
+    Pin_t pin,          ///< Pin to read
+    bool* levelPtr      ///< [OUT] true if the line is high
+)
+{
+    char varName[32];
+    char path[PATH_MAX];
+    char value = '\0';
+
+    snprintf(varName, sizeof(varName), "MUXCTRL_TEST_SIM_%u", Pins[pin].expander);
+    const char* chipDirPtr = getenv(varName);
+    if (chipDirPtr == NULL)
+    {
+        LE_ERROR("%s is not set", varName);
+        return LE_FAULT;
+    }
+
+    snprintf(path, sizeof(path), "%s/sim_gpio%u/value", chipDirPtr, Pins[pin].expanderPin);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        LE_ERROR("Can't open %s (%m)", path);
+        return LE_FAULT;
+    }
+
+    ssize_t count = read(fd, &value, 1);
+    close(fd);
+    if ((count != 1) || ((value != '0') && (value != '1')))
+    {
+        LE_ERROR("Can't read %s", path);
+        return LE_FAULT;
+    }
+
+    *levelPtr = (value == '1');
+
+    return LE_OK;
+}
+
+COMPONENT_INIT
+{
+    size_t checks = 0;
+
+    for (int i = 0; i < NUM_ARRAY_MEMBERS(Operations); i++)
+    {
+        checks += 1 + Operations[i].pinCount;
+    }
+    LE_TEST_PLAN(checks);
+
+    // Don't let a coalescing window merge the operations being checked.
+    mangoh_muxCtrl_SetCoalescingWindow(0);
+
+    for (int i = 0; i < NUM_ARRAY_MEMBERS(Operations); i++)
+    {
+        LE_TEST_OK(Operations[i].function() == LE_OK, "%s succeeds", Operations[i].name);
+
+        for (int j = 0; j < Operations[i].pinCount; j++)
+        {
+            Pin_t pin = Operations[i].pins[j].pin;
+            bool active = Operations[i].pins[j].active;
+            bool level = false;
+
+            // An active-low pin is active when its line is low.
+            le_result_t result = ReadLevel(pin, &level);
+            LE_TEST_OK((result == LE_OK) && (level == (active != Pins[pin].activeLow)),
+                       "%s leaves %s %s", Operations[i].name, Pins[pin].name,
+                       active ? "active" : "inactive");
+        }
+    }
+
+    LE_TEST_EXIT;
+}
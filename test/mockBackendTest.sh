@@ -0,0 +1,42 @@
+#!/bin/sh
+# Checks the backend calls each mux operation makes, that injected write failures fail the
+# operations that hit them, and the slot boundaries of bus schedules, using the call log, failure
+# injection and simulated latency of the mock backend.
+#
+# Usage: mockBackendTest.sh
+
+. "$(dirname "$0")/testLib.sh"
+
+# Every FAIL_EVERY-th pin change fails in the failure test.
+FAIL_EVERY=3
+
+# Each backend call takes LATENCY_US in the scheduler test, so that a switch can be caught while it
+# is in progress.
+LATENCY_US=200000
+
+# The service writes the log in its sandbox, unless it runs unsandboxed.
+SERVICE_LOG=/tmp/muxCtrlMock.log
+if [ "$(config get "$SERVICE_CONFIG/sandboxed")" = false ]; then
+    LOG=$SERVICE_LOG
+else
+    LOG=/legato/sandboxes/muxCtrlService$SERVICE_LOG
+fi
+
+SetServiceEnv MUXCTRL_BACKEND mock
+SetServiceEnv MUXCTRL_MOCK_LOG "$SERVICE_LOG"
+SetTestEnv mockLogTest MUXCTRL_TEST_MOCK_LOG "$LOG"
+SetTestEnv mockFailureTest MUXCTRL_TEST_MOCK_LOG "$LOG"
+SetTestEnv mockFailureTest MUXCTRL_TEST_MOCK_FAIL_EVERY "$FAIL_EVERY"
+SetTestEnv schedulerTest MUXCTRL_TEST_MOCK_LOG "$LOG"
+
+RestartService
+RunTest mockLogTest || exit 1
+
+SetServiceEnv MUXCTRL_MOCK_FAIL_EVERY "$FAIL_EVERY"
+RestartService
+RunTest mockFailureTest || exit 1
+
+SetServiceEnv MUXCTRL_MOCK_FAIL_EVERY 0
+SetServiceEnv MUXCTRL_MOCK_LATENCY_US "$LATENCY_US"
+RestartService
+RunTest schedulerTest
@@ -0,0 +1,115 @@
+/**
+ * @file
+ *
+ * Checks that a failed expander write fails the operation that made it, using the failure
+ * injection of the mock backend (MUXCTRL_BACKEND=mock with MUXCTRL_MOCK_FAIL_EVERY=N): every Nth
+ * call that changes a pin fails, so exactly those operations must fail and be logged as failed.
+ *
+ * N and the path of the mock's call log, as seen by this process, come from the environment
+ * variables MUXCTRL_TEST_MOCK_FAIL_EVERY and MUXCTRL_TEST_MOCK_LOG; test/mockBackendTest.sh sets
+ * these up.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of operations to run.
+ */
+//--------------------------------------------------------------------------------------------------
+#define NUM_OPERATIONS 12
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Longest line of the call log.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_LINE_LEN 128
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the result of the last call logged.
+ *
+ * @return
+ *      The result as logged, or "" if the log can't be read.
+ */
+//--------------------------------------------------------------------------------------------------
+static const char* GetLastResult
+(
+    FILE* logFile,      ///< Call log
+    char* resultPtr,    ///< Buffer for the result
+    size_t resultSize   ///< Size of the resultPtr buffer
+)
+{
+    char line[MAX_LINE_LEN];
+
+    resultPtr[0] = '\0';
+    clearerr(logFile);
+    while (fgets(line, sizeof(line), logFile) != NULL)
+    {
+        line[strcspn(line, "\n")] = '\0';
+        const char* textPtr = strrchr(line, ' ');
+        snprintf(resultPtr, resultSize, "%s", (textPtr != NULL) ? textPtr + 1 : line);
+    }
+
+    return resultPtr;
+}
+
+COMPONENT_INIT
+{
+    char result[MAX_LINE_LEN];
+
+    LE_TEST_PLAN(2 * NUM_OPERATIONS);
+
+    const char* failEveryPtr = getenv("MUXCTRL_TEST_MOCK_FAIL_EVERY");
+    uint32_t failEvery = (failEveryPtr != NULL) ? strtoul(failEveryPtr, NULL, 0) : 0;
+    if (failEvery == 0)
+    {
+        LE_FATAL("MUXCTRL_TEST_MOCK_FAIL_EVERY must be set to the mock's MUXCTRL_MOCK_FAIL_EVERY");
+    }
+
+    const char* logPathPtr = getenv("MUXCTRL_TEST_MOCK_LOG");
+    FILE* logFile = (logPathPtr != NULL) ? fopen(logPathPtr, "r") : NULL;
+    if (logFile == NULL)
+    {
+        LE_FATAL("Can't open the mock call log (MUXCTRL_TEST_MOCK_LOG=%s)",
+                 (logPathPtr != NULL) ? logPathPtr : "not set");
+    }
+
+    // Don't let a coalescing window delay or merge the requests being checked.
+    mangoh_muxCtrl_SetCoalescingWindow(0);
+
+    // The service may have kept the SDIO mux wherever an earlier test left it, so move it to the
+    // MicroSD slot first, so that the first operation changes it too.  Should this fail, the pin's
+    // state is unknown to the service, and the first operation writes it anyway.
+    mangoh_muxCtrl_SdioSelMicroSd();
+
+    for (int i = 0; i < NUM_OPERATIONS; i++)
+    {
+        // Each operation moves the SDIO mux, which is one pin change on one expander, and the mock
+        // counts the pin changes made so far as its bus transactions.
+        uint32_t changes;
+        mangoh_muxCtrl_GetBusTransactionCount(&changes);
+        bool shouldFail = (((changes + 1) % failEvery) == 0);
+        le_result_t expected = shouldFail ? LE_FAULT : LE_OK;
+
+        le_result_t actual = (i % 2) ? mangoh_muxCtrl_SdioSelMicroSd() :
+                                       mangoh_muxCtrl_SdioSelIot0();
+        LE_TEST_OK(actual == expected, "change %u returns %s (%s expected)",
+                   changes + 1, LE_RESULT_TXT(actual), LE_RESULT_TXT(expected));
+
+        GetLastResult(logFile, result, sizeof(result));
+        LE_TEST_OK(strcmp(result, LE_RESULT_TXT(expected)) == 0,
+                   "change %u is logged as %s", changes + 1, result);
+    }
+
+    fclose(logFile);
+
+    LE_TEST_EXIT;
+}
@@ -0,0 +1,225 @@
+/**
+ * @file
+ *
+ * Checks the calls the mux control service makes to its backend for each operation, from the call
+ * log of the mock backend (MUXCTRL_BACKEND=mock): the pins are configured at start-up selects
+ * first, the pins an operation changes on an expander are set with one write, and an operation
+ * that changes nothing makes no call.
+ *
+ * The path of the mock's call log, as seen by this process, comes from the environment variable
+ * MUXCTRL_TEST_MOCK_LOG; test/mockBackendTest.sh sets this up.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Longest line of the call log.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_LINE_LEN 128
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Put SPI in a known state with both of its pins inactive.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t SpiOffFromIot1
+(
+    void
+)
+{
+    le_result_t result = mangoh_muxCtrl_Iot1Spi1On();
+
+    return (result == LE_OK) ? mangoh_muxCtrl_IotAllSpiOff() : result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Operations to check, the operation run first to move their mux somewhere else, and the call
+ * each is expected to log, without its time stamp.  The masks and values have a bit for each pin
+ * in the order of pinState_Pin_t, set if the pin is active.
+ */
+//--------------------------------------------------------------------------------------------------
+static const struct
+{
+    const char* name;
+    le_result_t (*setup)(void);
+    le_result_t (*function)(void);
+    const char* call;
+}
+Operations[] =
+{
+    {
+        .name = "Iot0Uart1On",
+        .setup = mangoh_muxCtrl_Iot1Uart1On,
+        .function = mangoh_muxCtrl_Iot0Uart1On,
+        .call = "write exp=1 mask=0x00000002 values=0x00000002 LE_OK"
+    },
+    {
+        .name = "IotAllUart1Off",
+        .setup = mangoh_muxCtrl_Iot0Uart1On,
+        .function = mangoh_muxCtrl_IotAllUart1Off,
+        .call = "write exp=1 mask=0x00000001 values=0x00000000 LE_OK"
+    },
+    {
+        .name = "Iot0Spi1On",
+        .setup = SpiOffFromIot1,
+        .function = mangoh_muxCtrl_Iot0Spi1On,
+        .call = "write exp=1 mask=0x0000000c values=0x0000000c LE_OK"
+    },
+    {
+        .name = "SdioSelIot0",
+        .setup = mangoh_muxCtrl_SdioSelMicroSd,
+        .function = mangoh_muxCtrl_SdioSelIot0,
+        .call = "write exp=1 mask=0x00000100 values=0x00000000 LE_OK"
+    },
+    {
+        .name = "ArduinoAssertReset",
+        .setup = mangoh_muxCtrl_ArduinoDeassertReset,
+        .function = mangoh_muxCtrl_ArduinoAssertReset,
+        .call = "write exp=1 mask=0x00002000 values=0x00002000 LE_OK"
+    },
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Call log of the mock backend.
+ */
+//--------------------------------------------------------------------------------------------------
+static FILE* LogFile;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Skip the calls logged so far.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SkipCalls
+(
+    void
+)
+{
+    clearerr(LogFile);
+    fseek(LogFile, 0, SEEK_END);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the next call logged, without its time stamp.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_NOT_FOUND if no other call has been logged
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t GetCall
+(
+    char* callPtr,      ///< [OUT] Call, as logged
+    size_t callSize     ///< Size of the callPtr buffer
+)
+{
+    char line[MAX_LINE_LEN];
+
+    clearerr(LogFile);
+    if (fgets(line, sizeof(line), LogFile) == NULL)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    line[strcspn(line, "\n")] = '\0';
+    const char* textPtr = strchr(line, ' ');
+    snprintf(callPtr, callSize, "%s", (textPtr != NULL) ? textPtr + 1 : line);
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the order in which the service configured the pins when it started: every select pin
+ * before any enable or reset, so that nothing was connected through a mux still pointing
+ * elsewhere.  Must be called before anything else is read from the log.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckStartOrder
+(
+    void
+)
+{
+    char call[MAX_LINE_LEN];
+    int selects = 0;
+    int others = 0;
+    bool selectAfterOther = false;
+
+    while (GetCall(call, sizeof(call)) == LE_OK)
+    {
+        char pin[MAX_LINE_LEN];
+        if (sscanf(call, "configure pin=%127s", pin) != 1)
+        {
+            continue;
+        }
+
+        if (strstr(pin, "Select") != NULL)
+        {
+            selects++;
+            selectAfterOther = selectAfterOther || (others > 0);
+        }
+        else
+        {
+            others++;
+        }
+    }
+
+    LE_TEST_OK((selects > 0) && (others > 0),
+               "start-up configures select and enable pins (%d and %d)", selects, others);
+    LE_TEST_OK(!selectAfterOther, "start-up configures the selects before the enables and resets");
+}
+
+COMPONENT_INIT
+{
+    char call[MAX_LINE_LEN];
+
+    LE_TEST_PLAN(2 + 4 * NUM_ARRAY_MEMBERS(Operations));
+
+    const char* logPathPtr = getenv("MUXCTRL_TEST_MOCK_LOG");
+    LogFile = (logPathPtr != NULL) ? fopen(logPathPtr, "r") : NULL;
+    if (LogFile == NULL)
+    {
+        LE_FATAL("Can't open the mock call log (MUXCTRL_TEST_MOCK_LOG=%s)",
+                 (logPathPtr != NULL) ? logPathPtr : "not set");
+    }
+
+    CheckStartOrder();
+
+    // Don't let a coalescing window delay or merge the requests being checked.
+    mangoh_muxCtrl_SetCoalescingWindow(0);
+
+    for (int i = 0; i < NUM_ARRAY_MEMBERS(Operations); i++)
+    {
+        LE_TEST_OK(Operations[i].setup() == LE_OK, "set up %s", Operations[i].name);
+
+        // The mock logs each call before returning it, so the log is complete once the
+        // operation has returned.
+        SkipCalls();
+        LE_TEST_OK(Operations[i].function() == LE_OK, "%s succeeds", Operations[i].name);
+
+        le_result_t result = GetCall(call, sizeof(call));
+        LE_TEST_OK((result == LE_OK) && (strcmp(call, Operations[i].call) == 0) &&
+                   (GetCall(call, sizeof(call)) == LE_NOT_FOUND),
+                   "%s only logs \"%s\"", Operations[i].name, Operations[i].call);
+
+        SkipCalls();
+        Operations[i].function();
+        LE_TEST_OK(GetCall(call, sizeof(call)) == LE_NOT_FOUND,
+                   "%s again logs no call", Operations[i].name);
+    }
+
+    fclose(LogFile);
+
+    LE_TEST_EXIT;
+}
@@ -0,0 +1,524 @@
+/**
+ * @file
+ *
+ * Checks the time-sliced schedules of a shared bus against the call log of the mock backend
+ * (MUXCTRL_BACKEND=mock): each boundary reports SLOT_ENDING, switches the mux no sooner than the
+ * guard time later, and only then reports SLOT_STARTED; the bus stays leased to the client running
+ * the schedule; and a schedule stopped, or whose client's session closes, while its switch is in
+ * progress reports nothing more and gives up its lease.
+ *
+ * The mock must be slowed down (MUXCTRL_MOCK_LATENCY_US) so that a switch is still in progress when
+ * the schedule is stopped.  The path of the mock's call log, as seen by this process, comes from
+ * the environment variable MUXCTRL_TEST_MOCK_LOG; test/mockBackendTest.sh sets these up.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Longest line of the call log.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_LINE_LEN 128
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Length of each slice and the guard time of the schedule whose boundaries are checked.
+ */
+//--------------------------------------------------------------------------------------------------
+#define SLICE_MS 300
+#define GUARD_MS 500
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * How much earlier than the guard time after SLOT_ENDING is received the switch may be logged,
+ * as the event takes a little time to reach this process.
+ */
+//--------------------------------------------------------------------------------------------------
+#define GUARD_SLACK_MS 10
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * How long to wait for events that must not come after a schedule is stopped.
+ */
+//--------------------------------------------------------------------------------------------------
+#define QUIET_MS 1000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * How long the whole test may take.
+ */
+//--------------------------------------------------------------------------------------------------
+#define TIMEOUT_MS 20000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * UART 1 select pin, in the masks of the call log.  It is set when IoT slot 0 has the bus.
+ */
+//--------------------------------------------------------------------------------------------------
+#define UART1_SELECT_BIT 0x2
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parts of the test, run one after the other.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    STEP_BOUNDARIES,        ///< Run a schedule through its boundaries, then stop it
+    STEP_STOP_SWITCHING,    ///< Stop a schedule while its first switch is in progress
+    STEP_CLOSE_SWITCHING    ///< Close a session while the switch of its schedule is in progress
+}
+Step_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * What another client, with its own session, does on its own thread.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    OTHER_TRY_LEASED_BUS,   ///< Try to take or switch UART 1 while it is leased
+    OTHER_START_AND_CLOSE   ///< Start a schedule and close the session straight away
+}
+OtherAction_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Slot events expected while the schedule whose boundaries are checked runs: two slices of IoT
+ * slot 0 and one of slot 1, after which the schedule is stopped.
+ */
+//--------------------------------------------------------------------------------------------------
+static const struct
+{
+    uint8_t slot;
+    mangoh_muxCtrl_SlotEvent_t event;
+}
+ExpectedEvents[] =
+{
+    { 0, MANGOH_MUXCTRL_SLOT_STARTED },
+    { 0, MANGOH_MUXCTRL_SLOT_ENDING },
+    { 1, MANGOH_MUXCTRL_SLOT_STARTED },
+    { 1, MANGOH_MUXCTRL_SLOT_ENDING },
+    { 0, MANGOH_MUXCTRL_SLOT_STARTED },
+    { 0, MANGOH_MUXCTRL_SLOT_ENDING },     // Reported by StopSchedule()
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Index of the event after which the schedule is stopped.
+ */
+//--------------------------------------------------------------------------------------------------
+#define STOP_AFTER_EVENT 4
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Call log of the mock backend.
+ */
+//--------------------------------------------------------------------------------------------------
+static FILE* LogFile;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Part of the test being run.
+ */
+//--------------------------------------------------------------------------------------------------
+static Step_t Step;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Slot events received in the current step, and when the last SLOT_ENDING was received (in
+ * milliseconds of the relative clock, which the mock also stamps its log with).
+ */
+//--------------------------------------------------------------------------------------------------
+static int EventCount;
+static uint64_t EndingMs;
+static bool EndingSeen;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of BusReleased events received for UART 1.
+ */
+//--------------------------------------------------------------------------------------------------
+static int ReleasedCount;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Ends the quiet time after a schedule is stopped, and the test if it takes too long.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_timer_Ref_t QuietTimer;
+static le_timer_Ref_t TimeoutTimer;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Convert a relative time to milliseconds.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t ToMs
+(
+    le_clk_Time_t time
+)
+{
+    return (uint64_t)time.sec * 1000 + time.usec / 1000;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Skip the calls logged so far.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SkipCalls
+(
+    void
+)
+{
+    clearerr(LogFile);
+    fseek(LogFile, 0, SEEK_END);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the next expander write logged.
+ *
+ * @return
+ *      - LE_OK
+ *      - LE_NOT_FOUND if no other write has been logged
+ *      - LE_FAULT if the next call logged is not a successful write
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t GetWrite
+(
+    uint64_t* timeMsPtr,    ///< [OUT] When the write was logged
+    uint32_t* maskPtr,      ///< [OUT] Pins written
+    uint32_t* valuesPtr     ///< [OUT] Values of the pins
+)
+{
+    char line[MAX_LINE_LEN];
+    long sec;
+    long usec;
+    unsigned int expander;
+    char result[MAX_LINE_LEN];
+
+    clearerr(LogFile);
+    if (fgets(line, sizeof(line), LogFile) == NULL)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    if ((sscanf(line, "%ld.%ld write exp=%u mask=0x%x values=0x%x %127s",
+                &sec, &usec, &expander, maskPtr, valuesPtr, result) != 6) ||
+        (strcmp(result, "LE_OK") != 0))
+    {
+        return LE_FAULT;
+    }
+
+    *timeMsPtr = (uint64_t)sec * 1000 + usec / 1000;
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Let another client, with its own session, act on the bus.  Runs on its own thread, which
+ * connects to the service.
+ */
+//--------------------------------------------------------------------------------------------------
+static void* OtherClientMain
+(
+    void* contextPtr    ///< What to do (OtherAction_t)
+)
+{
+    static const uint8_t slots[] = { 0, 1 };
+    static const uint32_t slicesMs[] = { SLICE_MS, SLICE_MS };
+
+    mangoh_muxCtrl_ConnectService();
+
+    switch ((OtherAction_t)(intptr_t)contextPtr)
+    {
+        case OTHER_TRY_LEASED_BUS:
+            LE_TEST_OK(mangoh_muxCtrl_AcquireBus(MANGOH_MUXCTRL_MUX_UART1) == LE_BUSY,
+                       "another client can't lease the scheduled bus");
+            LE_TEST_OK(mangoh_muxCtrl_StartSchedule(MANGOH_MUXCTRL_MUX_UART1,
+                                                    slots, NUM_ARRAY_MEMBERS(slots),
+                                                    slicesMs, NUM_ARRAY_MEMBERS(slicesMs),
+                                                    0) == LE_BUSY,
+                       "another client can't schedule the scheduled bus");
+            LE_TEST_OK(mangoh_muxCtrl_Iot1Uart1On() == LE_NOT_PERMITTED,
+                       "another client can't switch the scheduled bus");
+            break;
+
+        case OTHER_START_AND_CLOSE:
+            LE_TEST_OK(mangoh_muxCtrl_StartSchedule(MANGOH_MUXCTRL_MUX_UART1,
+                                                    slots, NUM_ARRAY_MEMBERS(slots),
+                                                    slicesMs, NUM_ARRAY_MEMBERS(slicesMs),
+                                                    0) == LE_OK,
+                       "another client starts a schedule on the released bus");
+            break;
+    }
+
+    mangoh_muxCtrl_DisconnectService();
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run another client to completion.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RunOtherClient
+(
+    OtherAction_t action
+)
+{
+    le_thread_Ref_t threadRef = le_thread_Create("OtherClient", OtherClientMain,
+                                                 (void*)(intptr_t)action);
+
+    le_thread_SetJoinable(threadRef);
+    le_thread_Start(threadRef);
+    le_thread_Join(threadRef, NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check a slot event of the schedule whose boundaries are checked against the switches logged
+ * since the previous one.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckBoundary
+(
+    uint8_t slot,
+    mangoh_muxCtrl_SlotEvent_t event
+)
+{
+    int index = EventCount++;
+    uint64_t timeMs;
+    uint32_t mask;
+    uint32_t values;
+
+    if (index >= NUM_ARRAY_MEMBERS(ExpectedEvents))
+    {
+        LE_TEST_OK(false, "unexpected event %d for IoT slot %u", event, slot);
+        return;
+    }
+
+    LE_TEST_OK((slot == ExpectedEvents[index].slot) && (event == ExpectedEvents[index].event),
+               "event %d is %d for IoT slot %u (got %d for IoT slot %u)", index,
+               ExpectedEvents[index].event, ExpectedEvents[index].slot, event, slot);
+
+    if (event == MANGOH_MUXCTRL_SLOT_ENDING)
+    {
+        EndingMs = ToMs(le_clk_GetRelativeTime());
+        EndingSeen = true;
+        LE_TEST_OK(GetWrite(&timeMs, &mask, &values) == LE_NOT_FOUND,
+                   "the mux is not switched before SLOT_ENDING %d", index);
+        return;
+    }
+
+    le_result_t result = GetWrite(&timeMs, &mask, &values);
+    LE_TEST_OK((result == LE_OK) && (mask & UART1_SELECT_BIT) &&
+               (((values & UART1_SELECT_BIT) != 0) == (slot == 0)) &&
+               (GetWrite(&timeMs, &mask, &values) == LE_NOT_FOUND),
+               "the mux is switched to IoT slot %u once before SLOT_STARTED %d", slot, index);
+
+    if (EndingSeen)
+    {
+        LE_TEST_OK((result == LE_OK) && (timeMs + GUARD_SLACK_MS >= EndingMs + GUARD_MS),
+                   "the switch to IoT slot %u waits out the guard time (%d ms)", slot,
+                   (int)(timeMs - EndingMs));
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the schedule on UART 1 while the switch it starts with is still in progress.
+ */
+//--------------------------------------------------------------------------------------------------
+static void StopWhileSwitching
+(
+    void
+)
+{
+    static const uint8_t slots[] = { 1, 0 };
+    static const uint32_t slicesMs[] = { SLICE_MS, SLICE_MS };
+
+    Step = STEP_STOP_SWITCHING;
+    EventCount = 0;
+
+    LE_TEST_OK(mangoh_muxCtrl_StartSchedule(MANGOH_MUXCTRL_MUX_UART1,
+                                            slots, NUM_ARRAY_MEMBERS(slots),
+                                            slicesMs, NUM_ARRAY_MEMBERS(slicesMs),
+                                            0) == LE_OK,
+               "start a schedule to stop while it switches");
+    LE_TEST_OK(mangoh_muxCtrl_StopSchedule(MANGOH_MUXCTRL_MUX_UART1) == LE_OK,
+               "stop the schedule while it switches");
+
+    le_timer_Start(QuietTimer);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handle a slot event.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SlotSwitchHandler
+(
+    mangoh_muxCtrl_MuxGroup_t bus,
+    uint8_t slot,
+    mangoh_muxCtrl_SlotEvent_t event,
+    void* contextPtr
+)
+{
+    if (bus != MANGOH_MUXCTRL_MUX_UART1)
+    {
+        return;
+    }
+
+    if (Step != STEP_BOUNDARIES)
+    {
+        EventCount++;
+        return;
+    }
+
+    CheckBoundary(slot, event);
+
+    if (EventCount == STOP_AFTER_EVENT + 1)
+    {
+        LE_TEST_OK(mangoh_muxCtrl_StopSchedule(MANGOH_MUXCTRL_MUX_UART1) == LE_OK,
+                   "stop the schedule");
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handle the release of a lease.  The schedule whose boundaries are checked gives up its lease
+ * when it is stopped, which moves the test on.
+ */
+//--------------------------------------------------------------------------------------------------
+static void BusReleasedHandler
+(
+    mangoh_muxCtrl_MuxGroup_t group,
+    void* contextPtr
+)
+{
+    if (group != MANGOH_MUXCTRL_MUX_UART1)
+    {
+        return;
+    }
+
+    ReleasedCount++;
+
+    if ((Step == STEP_BOUNDARIES) && (ReleasedCount == 1))
+    {
+        LE_TEST_OK(EventCount == NUM_ARRAY_MEMBERS(ExpectedEvents),
+                   "all the slot events came before the lease was given up (%d)", EventCount);
+        StopWhileSwitching();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check that a schedule stopped while it switched reported nothing more and gave up its lease,
+ * then move on to the next step.
+ */
+//--------------------------------------------------------------------------------------------------
+static void QuietTimerExpired
+(
+    le_timer_Ref_t timer
+)
+{
+    if (Step == STEP_STOP_SWITCHING)
+    {
+        LE_TEST_OK(EventCount == 0, "a schedule stopped while it switches reports nothing (%d)",
+                   EventCount);
+        LE_TEST_OK(ReleasedCount == 2, "a schedule stopped while it switches gives up its lease");
+
+        Step = STEP_CLOSE_SWITCHING;
+        EventCount = 0;
+        RunOtherClient(OTHER_START_AND_CLOSE);
+        le_timer_Start(QuietTimer);
+        return;
+    }
+
+    LE_TEST_OK(EventCount == 0,
+               "a schedule whose session closed while it switches reports nothing (%d)",
+               EventCount);
+    LE_TEST_OK(ReleasedCount == 3,
+               "a schedule whose session closed while it switches gives up its lease");
+    LE_TEST_OK(mangoh_muxCtrl_AcquireBus(MANGOH_MUXCTRL_MUX_UART1) == LE_OK,
+               "the bus can be leased once the schedule is gone");
+    LE_TEST_OK(mangoh_muxCtrl_ReleaseBus(MANGOH_MUXCTRL_MUX_UART1) == LE_OK,
+               "the lease can be given up");
+
+    fclose(LogFile);
+
+    LE_TEST_EXIT;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Give up if the events the test waits for don't come.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TimeoutTimerExpired
+(
+    le_timer_Ref_t timer
+)
+{
+    LE_TEST_OK(false, "timed out in step %d after %d slot events", Step, EventCount);
+    LE_TEST_EXIT;
+}
+
+COMPONENT_INIT
+{
+    static const uint8_t slots[] = { 0, 1 };
+    static const uint32_t slicesMs[] = { SLICE_MS, SLICE_MS };
+
+    LE_TEST_PLAN(31);
+
+    const char* logPathPtr = getenv("MUXCTRL_TEST_MOCK_LOG");
+    LogFile = (logPathPtr != NULL) ? fopen(logPathPtr, "r") : NULL;
+    if (LogFile == NULL)
+    {
+        LE_FATAL("Can't open the mock call log (MUXCTRL_TEST_MOCK_LOG=%s)",
+                 (logPathPtr != NULL) ? logPathPtr : "not set");
+    }
+
+    QuietTimer = le_timer_Create("Quiet");
+    le_timer_SetMsInterval(QuietTimer, QUIET_MS);
+    le_timer_SetHandler(QuietTimer, QuietTimerExpired);
+
+    TimeoutTimer = le_timer_Create("Timeout");
+    le_timer_SetMsInterval(TimeoutTimer, TIMEOUT_MS);
+    le_timer_SetHandler(TimeoutTimer, TimeoutTimerExpired);
+    le_timer_Start(TimeoutTimer);
+
+    mangoh_muxCtrl_AddSlotSwitchHandler(SlotSwitchHandler, NULL);
+    mangoh_muxCtrl_AddBusReleasedHandler(BusReleasedHandler, NULL);
+
+    // Don't let a coalescing window delay the switches, and leave UART 1 off and pointing at IoT
+    // slot 1 so that the first switch changes its select pin.
+    mangoh_muxCtrl_SetCoalescingWindow(0);
+    le_result_t result = mangoh_muxCtrl_Iot1Uart1On();
+    LE_TEST_OK((result == LE_OK) && (mangoh_muxCtrl_IotAllUart1Off() == LE_OK),
+               "turn UART 1 off from IoT slot 1");
+
+    Step = STEP_BOUNDARIES;
+    SkipCalls();
+    LE_TEST_OK(mangoh_muxCtrl_StartSchedule(MANGOH_MUXCTRL_MUX_UART1,
+                                            slots, NUM_ARRAY_MEMBERS(slots),
+                                            slicesMs, NUM_ARRAY_MEMBERS(slicesMs),
+                                            GUARD_MS) == LE_OK,
+               "start a schedule on UART 1");
+    LE_TEST_OK(mangoh_muxCtrl_ReleaseBus(MANGOH_MUXCTRL_MUX_UART1) == LE_BUSY,
+               "the lease can't be given up while the schedule runs");
+
+    RunOtherClient(OTHER_TRY_LEASED_BUS);
+}
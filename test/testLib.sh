@@ -0,0 +1,60 @@
+# Helpers shared by the muxCtrlService test scripts.  Source this file; don't run it.
+#
+# The scripts run on a Legato system (a target, or a localhost build for the stand-in backends)
+# with muxCtrlService and test/muxCtrlTest.adef installed.  Each one sets up the service's
+# environment in the config tree, restarts the service and runs one test process, which prints
+# TAP and exits non-zero if a check failed.  The service's original configuration is restored when
+# the script exits, after which the script's own Cleanup function runs, if it defines one.
+
+SERVICE_CONFIG=system:/apps/muxCtrlService
+TEST_CONFIG=system:/apps/muxCtrlTest
+SAVED_CONFIG=$(mktemp)
+
+config export "$SERVICE_CONFIG" "$SAVED_CONFIG" || exit 1
+
+RestoreService()
+{
+    status=$?
+    config import "$SERVICE_CONFIG" "$SAVED_CONFIG"
+    rm -f "$SAVED_CONFIG"
+    app restart muxCtrlService
+    if command -v Cleanup > /dev/null; then
+        Cleanup
+    fi
+    exit $status
+}
+trap RestoreService EXIT
+
+# SetServiceEnv <name> <value>: set an environment variable of the service process.
+SetServiceEnv()
+{
+    config set "$SERVICE_CONFIG/procs/muxCtrlService/envVars/$1" "$2"
+}
+
+# AddServiceDevice <path>: give the service read and write access to a device file.
+AddServiceDevice()
+{
+    DEVICE_CONFIG="$SERVICE_CONFIG/requires/devices/test$(basename "$1")"
+    config set "$DEVICE_CONFIG/src" "$1"
+    config set "$DEVICE_CONFIG/dest" "$1"
+    config set "$DEVICE_CONFIG/isReadable" true bool
+    config set "$DEVICE_CONFIG/isWritable" true bool
+}
+
+# SetTestEnv <process> <name> <value>: set an environment variable of a test process.
+SetTestEnv()
+{
+    config set "$TEST_CONFIG/procs/$1/envVars/$2" "$3"
+}
+
+# RestartService: restart the service so that it picks up its new environment.
+RestartService()
+{
+    app restart muxCtrlService
+}
+
+# RunTest <process>: run one test process of muxCtrlTest and return its exit code.
+RunTest()
+{
+    app runProc muxCtrlTest "$1"
+}
@@ -0,0 +1,202 @@
+/**
+ * @file
+ *
+ * Checks the number of GPIO expander writes the mux control service makes for each operation:
+ * the pins an operation changes are written with at most one write per expander, and an operation
+ * that changes nothing writes nothing.
+ *
+ * Run it against the service with a stand-in backend (MUXCTRL_BACKEND=stub or mock), e.g. with
+ * test/writeCountTest.sh.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Operations to check, the operation run first to move their mux somewhere else, and the most
+ * expander writes each may make.  The limits are the number of expanders that the pins of the
+ * operation are on (see pinState.c).
+ */
+//--------------------------------------------------------------------------------------------------
+static const struct
+{
+    const char* name;
+    le_result_t (*setup)(void);
+    le_result_t (*function)(void);
+    uint32_t maxWrites;
+}
+Operations[] =
+{
+    {
+        .name = "Iot0Uart1On",
+        .setup = mangoh_muxCtrl_Iot1Uart1On,
+        .function = mangoh_muxCtrl_Iot0Uart1On,
+        .maxWrites = 1
+    },
+    {
+        .name = "Iot1Uart1On",
+        .setup = mangoh_muxCtrl_Iot0Uart1On,
+        .function = mangoh_muxCtrl_Iot1Uart1On,
+        .maxWrites = 1
+    },
+    {
+        .name = "Iot0Spi1On",
+        .setup = mangoh_muxCtrl_Iot1Spi1On,
+        .function = mangoh_muxCtrl_Iot0Spi1On,
+        .maxWrites = 1
+    },
+    {
+        .name = "Iot1Spi1On",
+        .setup = mangoh_muxCtrl_Iot0Spi1On,
+        .function = mangoh_muxCtrl_Iot1Spi1On,
+        .maxWrites = 1
+    },
+    {
+        .name = "Iot2Uart2On",
+        .setup = mangoh_muxCtrl_Uart2DebugOn,
+        .function = mangoh_muxCtrl_Iot2Uart2On,
+        .maxWrites = 2
+    },
+    {
+        .name = "Uart2DebugOn",
+        .setup = mangoh_muxCtrl_Iot2Uart2On,
+        .function = mangoh_muxCtrl_Uart2DebugOn,
+        .maxWrites = 2
+    },
+    {
+        .name = "SdioSelIot0",
+        .setup = mangoh_muxCtrl_SdioSelMicroSd,
+        .function = mangoh_muxCtrl_SdioSelIot0,
+        .maxWrites = 1
+    },
+    {
+        .name = "SdioSelMicroSd",
+        .setup = mangoh_muxCtrl_SdioSelIot0,
+        .function = mangoh_muxCtrl_SdioSelMicroSd,
+        .maxWrites = 1
+    },
+    {
+        .name = "AudioSelectIot0Codec",
+        .setup = mangoh_muxCtrl_AudioSelectInternalCodec,
+        .function = mangoh_muxCtrl_AudioSelectIot0Codec,
+        .maxWrites = 2
+    },
+    {
+        .name = "AudioSelectOnboardCodec",
+        .setup = mangoh_muxCtrl_AudioSelectIot0Codec,
+        .function = mangoh_muxCtrl_AudioSelectOnboardCodec,
+        .maxWrites = 2
+    },
+    {
+        .name = "AudioSelectInternalCodec",
+        .setup = mangoh_muxCtrl_AudioSelectOnboardCodec,
+        .function = mangoh_muxCtrl_AudioSelectInternalCodec,
+        .maxWrites = 2
+    },
+    {
+        .name = "AudioDisable",
+        .setup = mangoh_muxCtrl_AudioSelectOnboardCodec,
+        .function = mangoh_muxCtrl_AudioDisable,
+        .maxWrites = 2
+    },
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of expander writes the service has made so far.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t GetWriteCount
+(
+    void
+)
+{
+    uint32_t writes;
+
+    mangoh_muxCtrl_GetExpanderWriteCount(&writes);
+
+    return writes;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run an operation and get the number of expander writes it made.
+ *
+ * @return
+ *      The result of the operation.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CountWrites
+(
+    le_result_t (*function)(void),  ///< Operation to run
+    uint32_t* writesPtr             ///< [OUT] Number of expander writes it made
+)
+{
+    uint32_t before = GetWriteCount();
+    le_result_t result = function();
+
+    *writesPtr = GetWriteCount() - before;
+
+    return result;
+}
+
+COMPONENT_INIT
+{
+    uint32_t writes;
+
+    LE_TEST_PLAN(4 * NUM_ARRAY_MEMBERS(Operations) + 4);
+
+    // Don't let a coalescing window delay or merge the requests being counted.
+    mangoh_muxCtrl_SetCoalescingWindow(0);
+
+    for (int i = 0; i < NUM_ARRAY_MEMBERS(Operations); i++)
+    {
+        LE_TEST_OK(Operations[i].setup() == LE_OK, "set up %s", Operations[i].name);
+
+        le_result_t result = CountWrites(Operations[i].function, &writes);
+        LE_TEST_OK(result == LE_OK, "%s succeeds", Operations[i].name);
+        LE_TEST_OK(writes <= Operations[i].maxWrites,
+                   "%s makes %u expander writes (at most %u)",
+                   Operations[i].name, writes, Operations[i].maxWrites);
+
+        result = CountWrites(Operations[i].function, &writes);
+        LE_TEST_OK((result == LE_OK) && (writes == 0),
+                   "%s again makes %u expander writes (0 expected)", Operations[i].name, writes);
+    }
+
+    // The whole routing in one call: the muxes are on expanders 1 and 3 only.
+    LE_TEST_OK(mangoh_muxCtrl_ApplyConfiguration(MANGOH_MUXCTRL_UART1_OFF,
+                                                 MANGOH_MUXCTRL_SPI_OFF,
+                                                 MANGOH_MUXCTRL_UART2_OFF,
+                                                 MANGOH_MUXCTRL_SDIO_MICROSD,
+                                                 MANGOH_MUXCTRL_AUDIO_DISABLED) == LE_OK,
+               "set up ApplyConfiguration");
+
+    uint32_t before = GetWriteCount();
+    le_result_t result = mangoh_muxCtrl_ApplyConfiguration(MANGOH_MUXCTRL_UART1_IOT0,
+                                                           MANGOH_MUXCTRL_SPI_IOT1,
+                                                           MANGOH_MUXCTRL_UART2_DEBUG,
+                                                           MANGOH_MUXCTRL_SDIO_IOT0,
+                                                           MANGOH_MUXCTRL_AUDIO_ONBOARD_CODEC);
+    writes = GetWriteCount() - before;
+    LE_TEST_OK(result == LE_OK, "ApplyConfiguration succeeds");
+    LE_TEST_OK(writes <= 2, "ApplyConfiguration makes %u expander writes (at most 2)", writes);
+
+    before = GetWriteCount();
+    result = mangoh_muxCtrl_ApplyConfiguration(MANGOH_MUXCTRL_UART1_IOT0,
+                                               MANGOH_MUXCTRL_SPI_IOT1,
+                                               MANGOH_MUXCTRL_UART2_DEBUG,
+                                               MANGOH_MUXCTRL_SDIO_IOT0,
+                                               MANGOH_MUXCTRL_AUDIO_ONBOARD_CODEC);
+    writes = GetWriteCount() - before;
+    LE_TEST_OK((result == LE_OK) && (writes == 0),
+               "ApplyConfiguration again makes %u expander writes (0 expected)", writes);
+
+    LE_TEST_EXIT;
+}
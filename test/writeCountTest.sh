@@ -0,0 +1,10 @@
+#!/bin/sh
+# Checks the number of expander writes each mux operation makes, using the stub backend.
+#
+# Usage: writeCountTest.sh
+
+. "$(dirname "$0")/testLib.sh"
+
+SetServiceEnv MUXCTRL_BACKEND stub
+RestartService
+RunTest writeCountTest
@@ -16,14 +16,23 @@
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Definition for connect service function pointer
+ * Definition for the function pointer of a service's non-blocking connect function
  */
 //--------------------------------------------------------------------------------------------------
-typedef void (*ConnectServiceFunc_t)
+typedef le_result_t (*TryConnectServiceFunc_t)
 (
     void
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * How long to wait for the service if --timeout-ms is not given, and how often to retry while
+ * waiting.
+ */
+//--------------------------------------------------------------------------------------------------
+#define DEFAULT_CONNECT_TIMEOUT_MS 5000
+#define CONNECT_RETRY_INTERVAL_MS  10
+
 //--------------------------------------------------------------------------------------------------
 /**
  * A table that lists the commands supported by the mux program
@@ -31,88 +40,169 @@ typedef void (*ConnectServiceFunc_t)
 //--------------------------------------------------------------------------------------------------
 static struct
 {
+    const char* name;
     le_result_t (* function)(void);
     const char* description;
 } commands[] =
 {
     {
+        .name="uart1-off",
         .function=mangoh_muxCtrl_IotAllUart1Off,
         .description="Turn UART 1 off for all IoT slots"
     },
     {
+        .name="uart1-iot0",
         .function=mangoh_muxCtrl_Iot0Uart1On,
         .description="Turn UART 1 on for IoT slot 0"
     },
     {
+        .name="uart1-iot1",
         .function=mangoh_muxCtrl_Iot1Uart1On,
         .description="Turn UART 1 on for IoT slot 1"
     },
     {
+        .name="spi-off",
         .function=mangoh_muxCtrl_IotAllSpiOff,
         .description="Turn SPI off for all IoT slots"
     },
     {
+        .name="spi-iot0",
         .function=mangoh_muxCtrl_Iot0Spi1On,
         .description="Turn SPI on for IoT slot 0"
     },
     {
+        .name="spi-iot1",
         .function=mangoh_muxCtrl_Iot1Spi1On,
         .description="Turn SPI on for IoT slot 1"
     },
     {
+        .name="uart2-off",
         .function=mangoh_muxCtrl_IotAllUart2Off,
         .description="Turn UART 2 off for all IoT slots"
     },
     {
+        .name="uart2-iot2",
         .function=mangoh_muxCtrl_Iot2Uart2On,
         .description="Turn UART 2 on for IoT slot 2"
     },
     {
+        .name="uart2-debug",
         .function=mangoh_muxCtrl_Uart2DebugOn,
         .description="Turn UART 2 on for debug port"
     },
     {
+        .name="sdio-microsd",
         .function=mangoh_muxCtrl_SdioSelMicroSd,
         .description="Select the microSD card on the SDIO mux"
     },
     {
+        .name="sdio-iot0",
         .function=mangoh_muxCtrl_SdioSelIot0,
         .description="Select IoT slot 0 on the SDIO mux"
     },
     {
+        .name="audio-off",
         .function=mangoh_muxCtrl_AudioDisable,
         .description="Disable audio"
     },
     {
+        .name="audio-iot0",
         .function=mangoh_muxCtrl_AudioSelectIot0Codec,
         .description="Select the audio codec in IoT slot 0"
     },
     {
+        .name="audio-onboard",
         .function=mangoh_muxCtrl_AudioSelectOnboardCodec,
         .description="Select the audio codec on the mangOH board"
     },
     {
+        .name="audio-internal",
         .function=mangoh_muxCtrl_AudioSelectInternalCodec,
         .description="Select the audio codec internal to the CF3 module"
     },
     {
+        .name="reset-iot0",
         .function=mangoh_muxCtrl_IotSlot0DeassertReset,
         .description="Reset IoT slot 0"
     },
     {
+        .name="reset-iot1",
         .function=mangoh_muxCtrl_IotSlot1DeassertReset,
         .description="Reset IoT slot 1"
     },
     {
+        .name="reset-iot2",
         .function=mangoh_muxCtrl_IotSlot2DeassertReset,
         .description="Reset IoT slot 2"
     },
     {
+        .name="reset-arduino",
         .function=mangoh_muxCtrl_ArduinoReset,
         .description="Reset Arduino"
     },
 };
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of commands that can be given on the command line.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_STEPS 64
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum length of a line of a script read from stdin, including the newline.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_SCRIPT_LINE_LEN 256
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of commands and arguments on a line of a script.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_LINE_TOKENS 32
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Kinds of command the mux program can run.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    STEP_COMMAND,       ///< One of the commands in the commands table
+    STEP_STATE,
+    STEP_STATS,
+    STEP_RESET_STATS,
+    STEP_TRACE,
+}
+StepKind_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * A command to run, parsed from the command line or from a script.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    StepKind_t kind;
+    int command;        ///< Index into the commands table if kind is STEP_COMMAND
+}
+Step_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Formats the trace command can print the trace in.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    TRACE_FORMAT_TEXT,
+    TRACE_FORMAT_CHROME,
+    TRACE_FORMAT_FTRACE,
+}
+TraceFormat_t;
+
 //--------------------------------------------------------------------------------------------------
 /**
  * programOptions holds information about what options were passed to the mux command.
@@ -121,11 +211,78 @@ static struct
 static struct
 {
     bool helpRequested;
-    bool commandSupplied;
-    bool validCommandSupplied;
-    int command;
+    int connectTimeoutMs;
+    const char* traceFormat;
+    TraceFormat_t traceFormatCode;
+    size_t numSteps;
+    const char* steps[MAX_STEPS];   ///< Commands and their arguments, as given
+    bool batch;         ///< More than one command is run, so each is numbered and timed
 } programOptions;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Names of the positions of each mux, indexed by the route enums of mangoh_muxCtrl.api.
+ */
+//--------------------------------------------------------------------------------------------------
+static const char* const Uart1Names[] =
+{
+    [MANGOH_MUXCTRL_UART1_OFF]  = "off",
+    [MANGOH_MUXCTRL_UART1_IOT0] = "IoT slot 0",
+    [MANGOH_MUXCTRL_UART1_IOT1] = "IoT slot 1",
+};
+
+static const char* const SpiNames[] =
+{
+    [MANGOH_MUXCTRL_SPI_OFF]  = "off",
+    [MANGOH_MUXCTRL_SPI_IOT0] = "IoT slot 0",
+    [MANGOH_MUXCTRL_SPI_IOT1] = "IoT slot 1",
+};
+
+static const char* const Uart2Names[] =
+{
+    [MANGOH_MUXCTRL_UART2_OFF]   = "off",
+    [MANGOH_MUXCTRL_UART2_IOT2]  = "IoT slot 2",
+    [MANGOH_MUXCTRL_UART2_DEBUG] = "debug port",
+};
+
+static const char* const SdioNames[] =
+{
+    [MANGOH_MUXCTRL_SDIO_MICROSD] = "microSD card",
+    [MANGOH_MUXCTRL_SDIO_IOT0]    = "IoT slot 0",
+};
+
+static const char* const AudioNames[] =
+{
+    [MANGOH_MUXCTRL_AUDIO_DISABLED]       = "disabled",
+    [MANGOH_MUXCTRL_AUDIO_IOT0_CODEC]     = "IoT slot 0 codec",
+    [MANGOH_MUXCTRL_AUDIO_ONBOARD_CODEC]  = "onboard codec",
+    [MANGOH_MUXCTRL_AUDIO_INTERNAL_CODEC] = "CF3 internal codec",
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The muxes and reset lines printed by the state command.  Reset lines have no position names.
+ */
+//--------------------------------------------------------------------------------------------------
+static const struct
+{
+    mangoh_muxCtrl_MuxGroup_t group;
+    const char* label;
+    const char* const* names;
+    size_t numNames;
+} StateItems[] =
+{
+    { MANGOH_MUXCTRL_MUX_UART1,  "UART 1", Uart1Names, NUM_ARRAY_MEMBERS(Uart1Names) },
+    { MANGOH_MUXCTRL_MUX_SPI,    "SPI",    SpiNames,   NUM_ARRAY_MEMBERS(SpiNames)   },
+    { MANGOH_MUXCTRL_MUX_UART2,  "UART 2", Uart2Names, NUM_ARRAY_MEMBERS(Uart2Names) },
+    { MANGOH_MUXCTRL_MUX_SDIO,   "SDIO",   SdioNames,  NUM_ARRAY_MEMBERS(SdioNames)  },
+    { MANGOH_MUXCTRL_MUX_AUDIO,  "Audio",  AudioNames, NUM_ARRAY_MEMBERS(AudioNames) },
+    { MANGOH_MUXCTRL_MUX_RESET_IOT0,    "IoT slot 0 reset", NULL, 0 },
+    { MANGOH_MUXCTRL_MUX_RESET_IOT1,    "IoT slot 1 reset", NULL, 0 },
+    { MANGOH_MUXCTRL_MUX_RESET_IOT2,    "IoT slot 2 reset", NULL, 0 },
+    { MANGOH_MUXCTRL_MUX_RESET_ARDUINO, "Arduino reset",    NULL, 0 },
+};
+
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -137,16 +294,101 @@ NAME:\n\
     mux - mangOH GPIO Mux Control tool\n\
 \n\
 SYNOPSIS:\n\
-    mux [--help] [<command_num>]\n\
+    mux [--help] [--timeout-ms=<ms>] [--format=text|chrome|ftrace]\n\
+        <command> [<command> ...]\n\
+    mux [--timeout-ms=<ms>] [--format=text|chrome|ftrace] -  < script\n\
+    mux [--timeout-ms=<ms>] [--format=text|chrome|ftrace] shell\n\
+\n\
+    where <command> is one of\n\
+        <command_num> | <command_name> | state | stats | reset-stats | trace |\n\
+        repeat <count> <command> [<command> ...] |\n\
+        stress <command> <command> <count>\n\
 \n\
 DESCRIPTION:\n\
     -h, --help\n\
         Display this help and exit.\n\
+\n\
+    --timeout-ms=<ms>\n\
+        Give up if the service can't be connected to within <ms> milliseconds\n\
+        (default 5000).  0 tries once and fails at once if the service is not\n\
+        running.  The time the connection took is printed.\n\
+\n\
+    More than one command can be given.  They are run in order over a single\n\
+    connection to the service, each is printed with the time it took, and\n\
+    the program stops with a non-zero exit status at the first one that\n\
+    fails.\n\
+\n\
+    -\n\
+        Read commands from stdin, separated by white space or newlines.\n\
+        Anything after a '#' on a line is a comment.\n\
+\n\
+    shell\n\
+        Read commands from stdin interactively, one line at a time, and print\n\
+        how long each took.  A failed command doesn't end the session.  help\n\
+        lists the commands and quit or end-of-file ends the session.\n\
+\n\
+    repeat <count> <command> [<command> ...]\n\
+        Run the rest of the line <count> times, then print how long it took.\n\
+\n\
+    stress <command> <command> <count>\n\
+        Switch a mux <count> times, alternating between two of the numbered\n\
+        commands, and print the switch rate and the latency of the calls.\n\
+        Only the summary is printed, e.g. stress uart1-iot0 uart1-iot1 1000.\n\
+\n\
+    state\n\
+        Print where each mux is routed and which targets are held in reset.\n\
+        The service answers from its own record without touching the GPIO\n\
+        expanders.\n\
+\n\
+    stats\n\
+        Print the number of calls and failures of each API function and GPIO\n\
+        pin, and the latency histogram of the GPIO calls.\n\
+\n\
+    reset-stats\n\
+        Reset the statistics printed by the stats command.\n\
+\n\
+    trace\n\
+        Print the most recent pin writes, each with its CLOCK_MONOTONIC time,\n\
+        the process ID of the client that asked for it, the API call and the\n\
+        result.  --format=chrome prints them as Chrome trace event JSON and\n\
+        --format=ftrace as ftrace text (tracing_mark_write events), so they can\n\
+        be merged with other traces.\n\
 \n\
     Commands:\n\
 ";
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Print the numbered commands with their names.
+ */
+//--------------------------------------------------------------------------------------------------
+static void PrintCommands
+(
+    FILE* fh
+)
+{
+    for (int i = 0; i < NUM_ARRAY_MEMBERS(commands); i++)
+    {
+        fprintf(fh, "        %2d. %-15s %s\n", i, commands[i].name, commands[i].description);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of microseconds since a time returned by le_clk_GetRelativeTime().
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t GetElapsedUs
+(
+    le_clk_Time_t startTime
+)
+{
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), startTime);
+
+    return (uint64_t)elapsed.sec * 1000000 + elapsed.usec;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Print the help message to stdout
@@ -174,10 +416,7 @@ static void PrintHelp
     }
 
     fputs(HelpMessage, fh);
-    for (int i = 0; i < NUM_ARRAY_MEMBERS(commands); i++)
-    {
-        fprintf(fh, "        %2d. %s\n", i, commands[i].description);
-    }
+    PrintCommands(fh);
     fputs("\n", fh);
 
     if (errorMessage)
@@ -188,97 +427,748 @@ static void PrintHelp
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Thread used to recover from problems connecting to a service, probably because the service is
- * down.  It will timeout after 5 seconds, print an error message, and then exit.
+ * Try calling the given function to connect to a service, retrying until it succeeds or the
+ * --timeout-ms deadline passes.  If the service can't be connected to in time, the program exits.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TryConnect
+(
+    TryConnectServiceFunc_t tryConnectFuncPtr  ///< Function to call to connect to service
+)
+{
+    // Print out message before trying to connect to service to give user some kind of feedback.
+    // It goes to stderr, like the rest of the connection messages, so that stdout only carries
+    // the output of the commands (e.g. a trace redirected to a file).
+    fprintf(stderr, "Connecting to service ...\n");
+
+    le_clk_Time_t startTime = le_clk_GetRelativeTime();
+    le_clk_Time_t timeout =
+    {
+        .sec = programOptions.connectTimeoutMs / 1000,
+        .usec = (programOptions.connectTimeoutMs % 1000) * 1000
+    };
+    le_clk_Time_t deadline = le_clk_Add(startTime, timeout);
+    le_result_t result;
+
+    for (;;)
+    {
+        result = tryConnectFuncPtr();
+        if (result == LE_OK)
+        {
+            break;
+        }
+
+        // Retrying only helps if the service may yet start; a missing binding won't appear.
+        if ((result != LE_UNAVAILABLE) || le_clk_GreaterThan(le_clk_GetRelativeTime(), deadline))
+        {
+            fprintf(stderr, "Error: Can't connect to muxCtrlService (%s).  Is it running?\n",
+                    LE_RESULT_TXT(result));
+            exit(EXIT_FAILURE);
+        }
+
+        struct timespec retryInterval = { 0, CONNECT_RETRY_INTERVAL_MS * 1000000 };
+        nanosleep(&retryInterval, NULL);
+    }
+
+    uint64_t elapsedUs = GetElapsedUs(startTime);
+    fprintf(stderr, "Connected in %" PRIu64 ".%03u ms\n",
+            elapsedUs / 1000, (unsigned)(elapsedUs % 1000));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Executes the command with the given number.
+ *
+ * @return
+ *      The result of the command.
  *
- * Once successfully connected to the service, this thread should be stopped.
+ * @note
+ *      The command number is not validated by this function.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ExecuteCommand
+(
+    int command  ///< Command number to execute
+)
+{
+    printf("Executing %d: %s\n", command, commands[command].description);
+    le_result_t result = (*(commands[command].function))();
+    if (result != LE_OK)
+    {
+        fprintf(stderr, "Command failed with result (%d)!\n", result);
+    }
+    else
+    {
+        printf("Success\n");
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Prints the position of every mux and reset line.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t PrintState
+(
+    void
+)
+{
+    for (int i = 0; i < NUM_ARRAY_MEMBERS(StateItems); i++)
+    {
+        int32_t position;
+        le_result_t result = mangoh_muxCtrl_GetPosition(StateItems[i].group, &position);
+
+        printf("%-18s ", StateItems[i].label);
+        if (result != LE_OK)
+        {
+            printf("unknown\n");
+        }
+        else if (StateItems[i].names == NULL)
+        {
+            printf("%s\n", position ? "held in reset" : "running");
+        }
+        else if ((position >= 0) && (position < StateItems[i].numNames))
+        {
+            printf("%s\n", StateItems[i].names[position]);
+        }
+        else
+        {
+            printf("invalid (%d)\n", position);
+        }
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Prints the call and pin statistics and the GPIO latency histogram.  Calls and pins that have
+ * never been used are left out.
  */
 //--------------------------------------------------------------------------------------------------
-static void* TimeoutThread
+static le_result_t PrintStats
 (
-    void* contextPtr  ///< Not used
+    void
 )
 {
-    // This thread doesn't have to do anything else, at least for now, so just sleep.
-    sleep(5);
+    char name[MANGOH_MUXCTRL_MAX_STATS_NAME_LEN + 1];
+    uint32_t count;
+    uint32_t failures;
+
+    printf("%-26s %10s %10s\n", "API call", "calls", "failures");
+    for (uint32_t i = 0;
+         mangoh_muxCtrl_GetCallStats(i, name, sizeof(name), &count, &failures) == LE_OK;
+         i++)
+    {
+        if (count != 0)
+        {
+            printf("%-26s %10u %10u\n", name, count, failures);
+        }
+    }
+
+    printf("\n%-26s %10s %10s\n", "GPIO pin", "writes", "failures");
+    for (uint32_t i = 0;
+         mangoh_muxCtrl_GetPinStats(i, name, sizeof(name), &count, &failures) == LE_OK;
+         i++)
+    {
+        if (count != 0)
+        {
+            printf("%-26s %10u %10u\n", name, count, failures);
+        }
+    }
+
+    uint32_t buckets[MANGOH_MUXCTRL_NUM_LATENCY_BUCKETS];
+    size_t numBuckets = NUM_ARRAY_MEMBERS(buckets);
+    uint32_t maxUs;
+
+    mangoh_muxCtrl_GetGpioLatencyHistogram(buckets, &numBuckets, &maxUs);
+
+    printf("\n%-26s %10s\n", "GPIO call latency (us)", "calls");
+    for (size_t i = 0; i < numBuckets; i++)
+    {
+        char range[32];
+
+        if (buckets[i] == 0)
+        {
+            continue;
+        }
 
-    fputs("Error: Can't connect to muxCtrlService.  Is it running?\n", stderr);
-    exit(EXIT_FAILURE);
+        if (i == 0)
+        {
+            snprintf(range, sizeof(range), "< 1");
+        }
+        else if (i == numBuckets - 1)
+        {
+            snprintf(range, sizeof(range), ">= %u", 1u << (i - 1));
+        }
+        else
+        {
+            snprintf(range, sizeof(range), "%u - %u", 1u << (i - 1), (1u << i) - 1);
+        }
+        printf("%-26s %10u\n", range, buckets[i]);
+    }
+    printf("%-26s %10u\n", "max", maxUs);
 
-    return NULL;
+    return LE_OK;
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Try calling the given function to connect to a service.  If can't connect to the service within
- * 5 seconds, then the program will exit.
+ * Resets the statistics printed by PrintStats().
  */
 //--------------------------------------------------------------------------------------------------
-static void TryConnect
+static le_result_t ResetStats
+(
+    void
+)
+{
+    mangoh_muxCtrl_ResetStats();
+    printf("Statistics reset\n");
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Prints the trace of pin writes in the format given by --format.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t PrintTrace
+(
+    void
+)
+{
+    TraceFormat_t format = programOptions.traceFormatCode;
+
+    // Fetch the names of the calls and pins the trace refers to.
+    static char callNames[64][MANGOH_MUXCTRL_MAX_STATS_NAME_LEN + 1];
+    static char pinNames[32][MANGOH_MUXCTRL_MAX_STATS_NAME_LEN + 1];
+    uint32_t numCalls = 0;
+    uint32_t numPins = 0;
+    uint32_t count;
+    uint32_t failures;
+
+    while ((numCalls < NUM_ARRAY_MEMBERS(callNames)) &&
+           (mangoh_muxCtrl_GetCallStats(numCalls, callNames[numCalls], sizeof(callNames[0]),
+                                        &count, &failures) == LE_OK))
+    {
+        numCalls++;
+    }
+    while ((numPins < NUM_ARRAY_MEMBERS(pinNames)) &&
+           (mangoh_muxCtrl_GetPinStats(numPins, pinNames[numPins], sizeof(pinNames[0]),
+                                       &count, &failures) == LE_OK))
+    {
+        numPins++;
+    }
+
+    if (format == TRACE_FORMAT_CHROME)
+    {
+        printf("{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+    }
+    else if (format == TRACE_FORMAT_FTRACE)
+    {
+        printf("# tracer: nop\n#\n");
+    }
+
+    uint32_t seq = 0;
+    bool first = true;
+    for (;;)
+    {
+        uint32_t seqs[MANGOH_MUXCTRL_TRACE_BATCH_LEN];
+        uint64_t timesNs[MANGOH_MUXCTRL_TRACE_BATCH_LEN];
+        int32_t clients[MANGOH_MUXCTRL_TRACE_BATCH_LEN];
+        uint32_t calls[MANGOH_MUXCTRL_TRACE_BATCH_LEN];
+        uint8_t pins[MANGOH_MUXCTRL_TRACE_BATCH_LEN];
+        bool values[MANGOH_MUXCTRL_TRACE_BATCH_LEN];
+        int32_t results[MANGOH_MUXCTRL_TRACE_BATCH_LEN];
+        size_t numEntries = NUM_ARRAY_MEMBERS(seqs);
+        size_t numTimes = numEntries;
+        size_t numClients = numEntries;
+        size_t numCallEntries = numEntries;
+        size_t numPinEntries = numEntries;
+        size_t numValues = numEntries;
+        size_t numResults = numEntries;
+
+        mangoh_muxCtrl_ReadTrace(seq, seqs, &numEntries, timesNs, &numTimes, clients, &numClients,
+                                 calls, &numCallEntries, pins, &numPinEntries, values, &numValues,
+                                 results, &numResults, &seq);
+        if (numEntries == 0)
+        {
+            break;
+        }
+
+        for (size_t i = 0; i < numEntries; i++)
+        {
+            const char* callPtr = (calls[i] < numCalls) ? callNames[calls[i]] : "start-up";
+            const char* pinPtr = (pins[i] < numPins) ? pinNames[pins[i]] : "?";
+            const char* resultPtr = LE_RESULT_TXT(results[i]);
+            unsigned long sec = timesNs[i] / 1000000000;
+            unsigned long nsec = timesNs[i] % 1000000000;
+
+            switch (format)
+            {
+                case TRACE_FORMAT_TEXT:
+                    printf("%8u %lu.%09lu client %-6d %-24s %s=%d %s\n",
+                           seqs[i], sec, nsec, clients[i], callPtr, pinPtr, values[i], resultPtr);
+                    break;
+
+                case TRACE_FORMAT_CHROME:
+                    printf("%s  {\"name\": \"%s %s=%d\", \"cat\": \"mux\", \"ph\": \"i\", "
+                           "\"s\": \"g\", \"ts\": %lu.%03lu, \"pid\": %d, \"tid\": %d, "
+                           "\"args\": {\"seq\": %u, \"result\": \"%s\"}}",
+                           first ? "" : ",\n", callPtr, pinPtr, values[i],
+                           (unsigned long)(timesNs[i] / 1000), (unsigned long)(timesNs[i] % 1000),
+                           clients[i], clients[i], seqs[i], resultPtr);
+                    break;
+
+                case TRACE_FORMAT_FTRACE:
+                    printf("%16s-%-5d [000] .... %lu.%06lu: tracing_mark_write: "
+                           "mux: %s %s=%d %s\n",
+                           "muxclient", clients[i], sec, nsec / 1000,
+                           callPtr, pinPtr, values[i], resultPtr);
+                    break;
+            }
+            first = false;
+        }
+    }
+
+    if (format == TRACE_FORMAT_CHROME)
+    {
+        printf("\n]}\n");
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tries to parse a string into a command that takes no arguments.
+ *
+ * @return
+ *      - LE_OK if the string is a valid command.
+ *      - LE_BAD_PARAMETER if it isn't.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ParseStep
 (
-    ConnectServiceFunc_t connectFuncPtr  ///< Function to call to connect to service
+    const char* cmdPtr,     ///< [IN] String containing candidate command
+    Step_t* stepPtr         ///< [OUT] The command
 )
 {
-    // Print out message before trying to connect to service to give user some kind of feedback
-    printf("Connecting to service ...\n");
+    static const struct
+    {
+        const char* name;
+        StepKind_t kind;
+    }
+    namedSteps[] =
+    {
+        { "state",       STEP_STATE       },
+        { "stats",       STEP_STATS       },
+        { "reset-stats", STEP_RESET_STATS },
+        { "trace",       STEP_TRACE       },
+    };
+
+    for (int i = 0; i < NUM_ARRAY_MEMBERS(namedSteps); i++)
+    {
+        if (strcmp(cmdPtr, namedSteps[i].name) == 0)
+        {
+            stepPtr->kind = namedSteps[i].kind;
+            return LE_OK;
+        }
+    }
+
+    stepPtr->kind = STEP_COMMAND;
+    for (int i = 0; i < NUM_ARRAY_MEMBERS(commands); i++)
+    {
+        if (strcmp(cmdPtr, commands[i].name) == 0)
+        {
+            stepPtr->command = i;
+            return LE_OK;
+        }
+    }
+
+    if ((le_utf8_ParseInt(&stepPtr->command, cmdPtr) != LE_OK) ||
+        (stepPtr->command < 0) ||
+        (stepPtr->command >= NUM_ARRAY_MEMBERS(commands)))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Runs one command.  In batch mode the command is numbered and the time it took is printed.
+ *
+ * @return
+ *      The result of the command.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t RunStep
+(
+    const char* cmdPtr,     ///< Command as it was given, for messages
+    const Step_t* stepPtr   ///< The command
+)
+{
+    static unsigned int stepNum = 0;
+    le_result_t result = LE_OK;
+
+    stepNum++;
+    if (programOptions.batch)
+    {
+        printf("[%u] %s\n", stepNum, cmdPtr);
+    }
+
+    le_clk_Time_t startTime = le_clk_GetRelativeTime();
+
+    switch (stepPtr->kind)
+    {
+        case STEP_COMMAND:
+            result = ExecuteCommand(stepPtr->command);
+            break;
+
+        case STEP_STATE:
+            result = PrintState();
+            break;
+
+        case STEP_STATS:
+            result = PrintStats();
+            break;
+
+        case STEP_RESET_STATS:
+            result = ResetStats();
+            break;
+
+        case STEP_TRACE:
+            result = PrintTrace();
+            break;
+    }
+
+    if (programOptions.batch)
+    {
+        uint64_t elapsedUs = GetElapsedUs(startTime);
+
+        printf("[%u] %s: %s in %" PRIu64 ".%03u ms\n",
+               stepNum, cmdPtr, LE_RESULT_TXT(result),
+               elapsedUs / 1000, (unsigned)(elapsedUs % 1000));
+    }
+
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Switches a mux back and forth between two positions and prints the switch rate and the latency
+ * of the calls.
+ *
+ * @return
+ *      LE_OK if every switch succeeded, or the result of the one that failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Stress
+(
+    int commandA,   ///< Command that switches the mux one way
+    int commandB,   ///< Command that switches it back
+    int count       ///< Number of switches
+)
+{
+    uint64_t minUs = UINT64_MAX;
+    uint64_t maxUs = 0;
+    uint64_t totalUs = 0;
+    le_result_t result = LE_OK;
+    int done;
+
+    printf("Switching %d times between %s and %s\n",
+           count, commands[commandA].name, commands[commandB].name);
     fflush(stdout);
 
-    // Use a separate thread for recovery.  It will be stopped once connected to the service.
-    // Make the thread joinable, so we can be sure the thread is stopped before continuing.
-    le_thread_Ref_t threadRef = le_thread_Create("timeout thread", TimeoutThread, NULL);
-    le_thread_SetJoinable(threadRef);
-    le_thread_Start(threadRef);
+    le_clk_Time_t startTime = le_clk_GetRelativeTime();
 
-    // Try connecting to the service
-    connectFuncPtr();
+    for (done = 0; done < count; done++)
+    {
+        int command = ((done % 2) == 0) ? commandA : commandB;
+        le_clk_Time_t callStartTime = le_clk_GetRelativeTime();
 
-    // Connected to the service, so stop the timeout thread
-    le_thread_Cancel(threadRef);
-    le_thread_Join(threadRef, NULL);
+        result = (*(commands[command].function))();
+
+        uint64_t callUs = GetElapsedUs(callStartTime);
+        if (result != LE_OK)
+        {
+            fprintf(stderr, "Switch %d (%s) failed with result %s\n",
+                    done + 1, commands[command].name, LE_RESULT_TXT(result));
+            break;
+        }
+
+        totalUs += callUs;
+        minUs = (callUs < minUs) ? callUs : minUs;
+        maxUs = (callUs > maxUs) ? callUs : maxUs;
+    }
+
+    uint64_t elapsedUs = GetElapsedUs(startTime);
+
+    if (done > 0)
+    {
+        printf("%d switches in %" PRIu64 ".%03u ms: %.1f switches/s, "
+               "latency min %" PRIu64 " avg %" PRIu64 " max %" PRIu64 " us\n",
+               done, elapsedUs / 1000, (unsigned)(elapsedUs % 1000),
+               (elapsedUs != 0) ? (done * 1e6 / elapsedUs) : 0.0,
+               minUs, totalUs / done, maxUs);
+    }
+
+    return result;
 }
 
+static le_result_t RunScript(bool interactive);
+
 //--------------------------------------------------------------------------------------------------
 /**
- * Executes the command with the given number.
+ * Runs a list of commands and their arguments, stopping at the first that fails.
  *
- * @note
- *      The command number is not validated by this function.
+ * repeat consumes the rest of the list, so it is always the last command of a list.
+ *
+ * @return
+ *      LE_OK if every command succeeded, or the result of the one that failed.
  */
 //--------------------------------------------------------------------------------------------------
-static void ExecuteCommand
+static le_result_t RunTokens
 (
-    int command  ///< Command number to execute
+    const char* const* tokensPtr,   ///< Commands and their arguments
+    size_t numTokens,               ///< Number of entries in tokensPtr
+    bool check                      ///< Only check the commands, without running them
 )
 {
-    TryConnect(mangoh_muxCtrl_ConnectService);
+    size_t i = 0;
 
-    printf("Executing %d: %s\n", command, commands[command].description);
-    le_result_t result = (*(commands[command].function))();
-    if (result != LE_OK)
+    while (i < numTokens)
     {
-        fprintf(stderr, "Command failed with result (%d)!\n", result);
+        const char* cmdPtr = tokensPtr[i++];
+        le_result_t result = LE_OK;
+
+        if (strcmp(cmdPtr, "repeat") == 0)
+        {
+            int count;
+
+            if ((numTokens - i < 2) ||
+                (le_utf8_ParseInt(&count, tokensPtr[i]) != LE_OK) ||
+                (count <= 0) ||
+                (RunTokens(tokensPtr + i + 1, numTokens - i - 1, true) != LE_OK))
+            {
+                fprintf(stderr, "Usage: repeat <count> <command> [<command> ...]\n");
+                return LE_BAD_PARAMETER;
+            }
+
+            if (!check)
+            {
+                le_clk_Time_t startTime = le_clk_GetRelativeTime();
+                int done;
+
+                for (done = 0; (done < count) && (result == LE_OK); done++)
+                {
+                    result = RunTokens(tokensPtr + i + 1, numTokens - i - 1, false);
+                }
+
+                uint64_t elapsedUs = GetElapsedUs(startTime);
+                printf("repeat: %d of %d passes in %" PRIu64 ".%03u ms\n",
+                       (result == LE_OK) ? done : done - 1, count,
+                       elapsedUs / 1000, (unsigned)(elapsedUs % 1000));
+            }
+            i = numTokens;
+        }
+        else if (strcmp(cmdPtr, "stress") == 0)
+        {
+            Step_t stepA;
+            Step_t stepB;
+            int count;
+
+            if ((numTokens - i < 3) ||
+                (ParseStep(tokensPtr[i], &stepA) != LE_OK) || (stepA.kind != STEP_COMMAND) ||
+                (ParseStep(tokensPtr[i + 1], &stepB) != LE_OK) || (stepB.kind != STEP_COMMAND) ||
+                (le_utf8_ParseInt(&count, tokensPtr[i + 2]) != LE_OK) ||
+                (count <= 0))
+            {
+                fprintf(stderr, "Usage: stress <command> <command> <count>\n");
+                return LE_BAD_PARAMETER;
+            }
+
+            if (!check)
+            {
+                result = Stress(stepA.command, stepB.command, count);
+            }
+            i += 3;
+        }
+        else if ((strcmp(cmdPtr, "-") == 0) || (strcmp(cmdPtr, "shell") == 0))
+        {
+            if (!check)
+            {
+                result = RunScript(strcmp(cmdPtr, "shell") == 0);
+            }
+        }
+        else
+        {
+            Step_t step;
+
+            if (ParseStep(cmdPtr, &step) != LE_OK)
+            {
+                fprintf(stderr, "Invalid command \"%s\"\n", cmdPtr);
+                return LE_BAD_PARAMETER;
+            }
+
+            if (!check)
+            {
+                result = RunStep(cmdPtr, &step);
+            }
+        }
+
+        if (result != LE_OK)
+        {
+            return result;
+        }
     }
-    else
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Runs the commands read from stdin.  A script stops at the first command that fails; an
+ * interactive shell reports the failure and carries on until quit or the end of its input.
+ *
+ * @return
+ *      LE_OK if every command succeeded or the shell was left, or the result of the command of
+ *      the script that failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t RunScript
+(
+    bool interactive    ///< Run as an interactive shell rather than a script
+)
+{
+    static bool readingStdin = false;
+    char line[MAX_SCRIPT_LINE_LEN];
+    unsigned int lineNum = 0;
+    bool prompt = interactive && isatty(STDIN_FILENO);
+    le_result_t result = LE_OK;
+
+    if (readingStdin)
     {
-        printf("Success\n");
+        fprintf(stderr, "Commands read from stdin can't read stdin again\n");
+        return LE_BAD_PARAMETER;
+    }
+    readingStdin = true;
+
+    for (;;)
+    {
+        if (prompt)
+        {
+            printf("mux> ");
+            fflush(stdout);
+        }
+
+        if (fgets(line, sizeof(line), stdin) == NULL)
+        {
+            break;
+        }
+        lineNum++;
+
+        const char* tokens[MAX_LINE_TOKENS];
+        size_t numTokens = 0;
+
+        if ((strchr(line, '\n') == NULL) && !feof(stdin))
+        {
+            fprintf(stderr, "Line %u is too long\n", lineNum);
+            result = LE_OVERFLOW;
+
+            // Drop the rest of the line.
+            int c;
+            do
+            {
+                c = getchar();
+            }
+            while ((c != '\n') && (c != EOF));
+        }
+        else
+        {
+            char* commentPtr = strchr(line, '#');
+            if (commentPtr != NULL)
+            {
+                *commentPtr = '\0';
+            }
+
+            char* savePtr;
+            for (char* tokenPtr = strtok_r(line, " \t\r\n", &savePtr);
+                 tokenPtr != NULL;
+                 tokenPtr = strtok_r(NULL, " \t\r\n", &savePtr))
+            {
+                if (numTokens >= NUM_ARRAY_MEMBERS(tokens))
+                {
+                    fprintf(stderr, "Line %u has too many words\n", lineNum);
+                    result = LE_OVERFLOW;
+                    break;
+                }
+                tokens[numTokens++] = tokenPtr;
+            }
+        }
+
+        if ((result == LE_OK) && (numTokens > 0))
+        {
+            if (interactive && (strcmp(tokens[0], "quit") == 0 || strcmp(tokens[0], "exit") == 0))
+            {
+                break;
+            }
+            else if (interactive && (strcmp(tokens[0], "help") == 0))
+            {
+                PrintCommands(stdout);
+                printf("        state | stats | reset-stats | trace\n"
+                       "        repeat <count> <command> [<command> ...]\n"
+                       "        stress <command> <command> <count>\n"
+                       "        quit\n");
+            }
+            else
+            {
+                result = RunTokens(tokens, numTokens, false);
+            }
+        }
+
+        if (result != LE_OK)
+        {
+            if (!interactive)
+            {
+                fprintf(stderr, "Stopping at line %u of the script\n", lineNum);
+                break;
+            }
+            result = LE_OK;
+        }
     }
+
+    if (prompt && feof(stdin))
+    {
+        printf("\n");
+    }
+
+    readingStdin = false;
+
+    return result;
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Tries to parse a string into a valid command int and updates programOptions accordingly.
+ * Adds a command or argument given on the command line to the list to run.  The list is checked
+ * once all the arguments have been scanned.
  */
 //--------------------------------------------------------------------------------------------------
 static void ParseCommand(
-    const char* cmdPtr  ///< String containing candidate command number
+    const char* cmdPtr  ///< String containing candidate command or argument
 )
 {
-    programOptions.commandSupplied = true;
-    le_result_t parseResult = le_utf8_ParseInt(&programOptions.command, cmdPtr);
-    programOptions.validCommandSupplied =
-        (parseResult == LE_OK) &&
-        programOptions.command >= 0 &&
-        programOptions.command < NUM_ARRAY_MEMBERS(commands);
+    if (programOptions.numSteps >= MAX_STEPS)
+    {
+        PrintHelp("Too many commands\n");
+    }
+
+    programOptions.steps[programOptions.numSteps++] = cmdPtr;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -343,9 +1233,13 @@ static size_t ArgumentErrorHandler
 
 COMPONENT_INIT
 {
-    // Allow for the possibility that the user didn't specify a command number
+    // Allow for the possibility that the user didn't specify a command, or specified several
     le_arg_AllowLessPositionalArgsThanCallbacks();
+    le_arg_AllowMorePositionalArgsThanCallbacks();
     le_arg_SetFlagVar(&programOptions.helpRequested, "h", "help");
+    programOptions.connectTimeoutMs = DEFAULT_CONNECT_TIMEOUT_MS;
+    le_arg_SetIntVar(&programOptions.connectTimeoutMs, NULL, "timeout-ms");
+    le_arg_SetStringVar(&programOptions.traceFormat, NULL, "format");
     le_arg_AddPositionalCallback(ParseCommand);
     le_arg_SetErrorHandler(ArgumentErrorHandler);
     le_arg_Scan();
@@ -353,21 +1247,54 @@ COMPONENT_INIT
     if (programOptions.helpRequested)
     {
         PrintHelp(NULL);
+        exit(0);
     }
-    else if (programOptions.commandSupplied)
+
+    if (programOptions.numSteps == 0)
     {
-        if (programOptions.validCommandSupplied)
-        {
-            ExecuteCommand(programOptions.command);
-        }
-        else
-        {
-            PrintHelp("Supplid command is invalid\n");
-        }
+        PrintHelp("No command was specified\n");
+    }
+
+    if (programOptions.connectTimeoutMs < 0)
+    {
+        PrintHelp("The connect timeout can't be negative\n");
+    }
+
+    if ((programOptions.traceFormat == NULL) || (strcmp(programOptions.traceFormat, "text") == 0))
+    {
+        programOptions.traceFormatCode = TRACE_FORMAT_TEXT;
+    }
+    else if (strcmp(programOptions.traceFormat, "chrome") == 0)
+    {
+        programOptions.traceFormatCode = TRACE_FORMAT_CHROME;
+    }
+    else if (strcmp(programOptions.traceFormat, "ftrace") == 0)
+    {
+        programOptions.traceFormatCode = TRACE_FORMAT_FTRACE;
     }
     else
     {
-        PrintHelp("No command was specified\n");
+        PrintHelp("Unknown trace format\n");
+    }
+
+    // Number and time the commands unless there is only one, so that stdout carries nothing but
+    // the output of a single command (e.g. a trace to be loaded into another tool).
+    Step_t step;
+    programOptions.batch = (programOptions.numSteps > 1) ||
+                           (ParseStep(programOptions.steps[0], &step) != LE_OK);
+
+    // Check the whole command line before running any of it.
+    if (RunTokens(programOptions.steps, programOptions.numSteps, true) != LE_OK)
+    {
+        PrintHelp("Supplied command is invalid\n");
+    }
+
+    // Every command is run over the same connection.
+    TryConnect(mangoh_muxCtrl_TryConnectService);
+
+    if (RunTokens(programOptions.steps, programOptions.numSteps, false) != LE_OK)
+    {
+        exit(EXIT_FAILURE);
     }
 
     exit(0);
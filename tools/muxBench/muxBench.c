@@ -0,0 +1,430 @@
+/**
+ * @file
+ *
+ * This file implements a benchmark of the mux control service.  It drives the mangoh_muxCtrl API
+ * repeatedly, one scenario at a time, and prints the throughput, latency percentiles and number
+ * of GPIO expander operations per call of each scenario as JSON on stdout.
+ *
+ * The benchmark is meant to be run against the service with a stand-in backend
+ * (MUXCTRL_BACKEND=stub or mock in muxCtrlService.adef), so that the numbers measure the service
+ * rather than the I2C bus, and can be compared from release to release.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless, Inc. Use of this work is subject to license.
+ */
+
+/* Legato Framework */
+#include "legato.h"
+#include "interfaces.h"
+
+#include <time.h>
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of calls in the cycle of a scenario.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_CYCLE_LEN 3
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of untimed calls made before timing each scenario.
+ */
+//--------------------------------------------------------------------------------------------------
+#define WARMUP_CALLS 10
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default number of timed calls per scenario.
+ */
+//--------------------------------------------------------------------------------------------------
+#define DEFAULT_ITERATIONS 1000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pulse the reset of IoT slot 0.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t PulseIot0Reset
+(
+    void
+)
+{
+    return mangoh_muxCtrl_PulseReset(MANGOH_MUXCTRL_RESET_IOT0);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Apply a routing with every mux on, in one request.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ApplyAllOn
+(
+    void
+)
+{
+    return mangoh_muxCtrl_ApplyConfiguration(MANGOH_MUXCTRL_UART1_IOT0,
+                                             MANGOH_MUXCTRL_SPI_IOT1,
+                                             MANGOH_MUXCTRL_UART2_DEBUG,
+                                             MANGOH_MUXCTRL_SDIO_IOT0,
+                                             MANGOH_MUXCTRL_AUDIO_ONBOARD_CODEC);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Apply a routing with every mux off, in one request.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ApplyAllOff
+(
+    void
+)
+{
+    return mangoh_muxCtrl_ApplyConfiguration(MANGOH_MUXCTRL_UART1_OFF,
+                                             MANGOH_MUXCTRL_SPI_OFF,
+                                             MANGOH_MUXCTRL_UART2_OFF,
+                                             MANGOH_MUXCTRL_SDIO_MICROSD,
+                                             MANGOH_MUXCTRL_AUDIO_DISABLED);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The scenarios.  Each one calls the functions of its cycle in turn, so that every call changes
+ * the routing.
+ */
+//--------------------------------------------------------------------------------------------------
+static const struct
+{
+    const char* name;
+    le_result_t (*cycle[MAX_CYCLE_LEN])(void);
+} Scenarios[] =
+{
+    { "uart1-slot-flip",  { mangoh_muxCtrl_Iot0Uart1On, mangoh_muxCtrl_Iot1Uart1On } },
+    { "spi-slot-flip",    { mangoh_muxCtrl_Iot0Spi1On, mangoh_muxCtrl_Iot1Spi1On } },
+    { "uart2-debug",      { mangoh_muxCtrl_Uart2DebugOn, mangoh_muxCtrl_IotAllUart2Off } },
+    { "sdio-flip",        { mangoh_muxCtrl_SdioSelIot0, mangoh_muxCtrl_SdioSelMicroSd } },
+    { "audio-path",       { mangoh_muxCtrl_AudioSelectOnboardCodec,
+                            mangoh_muxCtrl_AudioSelectIot0Codec,
+                            mangoh_muxCtrl_AudioDisable } },
+    { "reset-pulse",      { PulseIot0Reset } },
+    { "apply-config",     { ApplyAllOn, ApplyAllOff } },
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * programOptions holds information about what options were passed to the muxBench command.
+ */
+//--------------------------------------------------------------------------------------------------
+static struct
+{
+    bool helpRequested;
+    int iterations;
+    const char* scenario;
+} programOptions =
+{
+    .iterations = DEFAULT_ITERATIONS,
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Help Message
+ */
+//--------------------------------------------------------------------------------------------------
+static char* HelpMessage = "\
+NAME:\n\
+    muxBench - mangOH GPIO Mux Control benchmark\n\
+\n\
+SYNOPSIS:\n\
+    muxBench [--help] [--iterations=<count>] [--scenario=<name>]\n\
+\n\
+DESCRIPTION:\n\
+    Calls the mux control service repeatedly and prints, as JSON, the\n\
+    throughput, the p50/p99/p999 latency and the number of GPIO expander\n\
+    operations per call of each scenario.  Run it against muxCtrlService\n\
+    with a stand-in backend (MUXCTRL_BACKEND=stub or mock).\n\
+\n\
+    -h, --help\n\
+        Display this help and exit.\n\
+\n\
+    -n, --iterations=<count>\n\
+        Number of timed calls per scenario (default 1000).\n\
+\n\
+    -s, --scenario=<name>\n\
+        Only run the named scenario.\n\
+\n\
+    Scenarios:\n\
+";
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Print the help message to stdout
+ *
+ * @note
+ *      This function exits with EXIT_FAILURE if errorMessage is not NULL.
+ */
+//--------------------------------------------------------------------------------------------------
+static void PrintHelp
+(
+    const char *errorMessage
+)
+{
+    FILE *fh = stdout;
+
+    if (errorMessage)
+    {
+        fh = stderr;
+        fputs("ERROR: ", fh);
+        fputs(errorMessage, fh);
+        fputs("\n", fh);
+    }
+
+    fputs(HelpMessage, fh);
+    for (int i = 0; i < NUM_ARRAY_MEMBERS(Scenarios); i++)
+    {
+        fprintf(fh, "        %s\n", Scenarios[i].name);
+    }
+    fputs("\n", fh);
+
+    if (errorMessage)
+    {
+        exit(EXIT_FAILURE);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the current time of the monotonic clock in nanoseconds.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t NowNs
+(
+    void
+)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compare two latencies, for qsort().
+ */
+//--------------------------------------------------------------------------------------------------
+static int CompareLatency
+(
+    const void* aPtr,
+    const void* bPtr
+)
+{
+    uint64_t a = *(const uint64_t*)aPtr;
+    uint64_t b = *(const uint64_t*)bPtr;
+
+    return (a > b) - (a < b);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a percentile of sorted latencies, in microseconds.
+ */
+//--------------------------------------------------------------------------------------------------
+static double Percentile
+(
+    const uint64_t* sortedPtr,
+    int count,
+    double percent
+)
+{
+    int index = (int)((percent / 100.0) * count);
+
+    if (index >= count)
+    {
+        index = count - 1;
+    }
+
+    return sortedPtr[index] / 1000.0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the counters of GPIO expander operations.  busTransactionsPtr is left alone if the backend
+ * does not count bus transactions.
+ *
+ * @return
+ *      true if the bus transaction count is valid
+ */
+//--------------------------------------------------------------------------------------------------
+static bool GetGpioCounters
+(
+    uint32_t* writesPtr,            ///< [OUT] Expander writes
+    uint32_t* busTransactionsPtr    ///< [OUT] Bus transactions
+)
+{
+    mangoh_muxCtrl_GetExpanderWriteCount(writesPtr);
+
+    return (mangoh_muxCtrl_GetBusTransactionCount(busTransactionsPtr) == LE_OK);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run one scenario and print its results as a JSON object.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RunScenario
+(
+    int scenario,       ///< Index of the scenario in Scenarios
+    uint64_t* latencyPtr  ///< Buffer for one latency per iteration
+)
+{
+    int cycleLen = 0;
+    while ((cycleLen < MAX_CYCLE_LEN) && (Scenarios[scenario].cycle[cycleLen] != NULL))
+    {
+        cycleLen++;
+    }
+
+    fprintf(stderr, "Running %s ...\n", Scenarios[scenario].name);
+
+    for (int i = 0; i < WARMUP_CALLS; i++)
+    {
+        Scenarios[scenario].cycle[i % cycleLen]();
+    }
+
+    uint32_t writesBefore = 0;
+    uint32_t transactionsBefore = 0;
+    bool haveTransactions = GetGpioCounters(&writesBefore, &transactionsBefore);
+    int failures = 0;
+
+    uint64_t startNs = NowNs();
+    for (int i = 0; i < programOptions.iterations; i++)
+    {
+        uint64_t callStartNs = NowNs();
+        if (Scenarios[scenario].cycle[i % cycleLen]() != LE_OK)
+        {
+            failures++;
+        }
+        latencyPtr[i] = NowNs() - callStartNs;
+    }
+    double seconds = (NowNs() - startNs) / 1e9;
+
+    uint32_t writesAfter = 0;
+    uint32_t transactionsAfter = 0;
+    haveTransactions = GetGpioCounters(&writesAfter, &transactionsAfter) && haveTransactions;
+
+    int count = programOptions.iterations;
+    qsort(latencyPtr, count, sizeof(latencyPtr[0]), CompareLatency);
+
+    printf("    {\n");
+    printf("      \"name\": \"%s\",\n", Scenarios[scenario].name);
+    printf("      \"calls\": %d,\n", count);
+    printf("      \"failures\": %d,\n", failures);
+    printf("      \"seconds\": %.6f,\n", seconds);
+    printf("      \"callsPerSecond\": %.1f,\n", count / seconds);
+    printf("      \"latencyUs\": { \"min\": %.1f, \"p50\": %.1f, \"p99\": %.1f, \"p999\": %.1f, "
+           "\"max\": %.1f },\n",
+           latencyPtr[0] / 1000.0,
+           Percentile(latencyPtr, count, 50.0),
+           Percentile(latencyPtr, count, 99.0),
+           Percentile(latencyPtr, count, 99.9),
+           latencyPtr[count - 1] / 1000.0);
+    printf("      \"expanderWritesPerCall\": %.3f,\n",
+           (double)(writesAfter - writesBefore) / count);
+    if (haveTransactions)
+    {
+        printf("      \"busTransactionsPerCall\": %.3f\n",
+               (double)(transactionsAfter - transactionsBefore) / count);
+    }
+    else
+    {
+        printf("      \"busTransactionsPerCall\": null\n");
+    }
+    printf("    }");
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handles errors generated by command line argument processing
+ *
+ * @return
+ *      Causes exit(EXIT_FAILURE), so never returns
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t ArgumentErrorHandler
+(
+    size_t  argIndex,       ///< Index of argument that is bad (0 = first arg after program name).
+    le_result_t errorCode   ///< Code indicating the type of error that was encountered.
+)
+{
+    char errorString[128];
+
+    snprintf(errorString, sizeof(errorString), "Invalid argument \"%s\" (%s)\n",
+             le_arg_GetArg(argIndex), LE_RESULT_TXT(errorCode));
+    PrintHelp(errorString);
+
+    return 0;
+}
+
+COMPONENT_INIT
+{
+    le_arg_SetFlagVar(&programOptions.helpRequested, "h", "help");
+    le_arg_SetIntVar(&programOptions.iterations, "n", "iterations");
+    le_arg_SetStringVar(&programOptions.scenario, "s", "scenario");
+    le_arg_SetErrorHandler(ArgumentErrorHandler);
+    le_arg_Scan();
+
+    if (programOptions.helpRequested)
+    {
+        PrintHelp(NULL);
+        exit(0);
+    }
+
+    if (programOptions.iterations <= 0)
+    {
+        PrintHelp("The number of iterations must be positive\n");
+    }
+
+    int first = 0;
+    int last = NUM_ARRAY_MEMBERS(Scenarios) - 1;
+    if (programOptions.scenario != NULL)
+    {
+        for (first = 0; first <= last; first++)
+        {
+            if (strcmp(programOptions.scenario, Scenarios[first].name) == 0)
+            {
+                break;
+            }
+        }
+        if (first > last)
+        {
+            PrintHelp("Unknown scenario\n");
+        }
+        last = first;
+    }
+
+    if (mangoh_muxCtrl_TryConnectService() != LE_OK)
+    {
+        fputs("Error: Can't connect to muxCtrlService.  Is it running?\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+
+    uint64_t* latencyPtr = malloc(programOptions.iterations * sizeof(uint64_t));
+    LE_ASSERT(latencyPtr != NULL);
+
+    printf("{\n");
+    printf("  \"iterations\": %d,\n", programOptions.iterations);
+    printf("  \"scenarios\": [\n");
+    for (int i = first; i <= last; i++)
+    {
+        RunScenario(i, latencyPtr);
+        printf("%s\n", (i < last) ? "," : "");
+    }
+    printf("  ]\n");
+    printf("}\n");
+
+    free(latencyPtr);
+
+    exit(0);
+}